@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "Analysis.h"
+#include "Log.h"
+
+Analysis::Analysis(std::size_t const hash_mb, Notify notify)
+  : tt{ hash_mb }
+  , notify{ std::move(notify) }
+  , worker{ [this](std::stop_token const token) { run(token); } }
+{}
+
+Analysis::~Analysis()
+{
+    worker.request_stop();
+    cancel.store(true);
+    posted.fetch_add(1, std::memory_order_release);
+    posted.notify_one();
+    worker.join();
+}
+
+uint64_t
+Analysis::analyse(BoardInfo const& board,
+                  std::vector<uint64_t> previous_positions)
+{
+    auto const id = ++next_id;
+    post({ .id = id,
+           .board = board,
+           .previous_positions = std::move(previous_positions) });
+    return id;
+}
+
+void
+Analysis::stop()
+{
+    post({ .id = ++next_id });
+}
+
+void
+Analysis::post(Request request)
+{
+    // only full when the thread hasn't run since the last few requests, the
+    // cancel raised by those has it emptying the queue any moment now
+    while (not requests.try_push(std::move(request)))
+        std::this_thread::yield();
+
+    // after the push: the thread clears it with an exchange before reading
+    // the queue. It may take this request before the store lands, then the
+    // search of it is cut short and the wake-up below has it search the same
+    // request again
+    cancel.store(true, std::memory_order_release);
+    posted.fetch_add(1, std::memory_order_release);
+    posted.notify_one();
+}
+
+void
+Analysis::publish(uint64_t const request,
+                  BoardInfo const& board,
+                  SearchInfo const& info,
+                  bool const finished)
+{
+    AnalysisUpdate update{
+        .request = request,
+        .depth = info.depth,
+        .score = info.score,
+        .turn = board.turn,
+        .nodes = info.nodes,
+        .finished = finished,
+        .pv_length = static_cast<uint8_t>(
+          std::min(info.pv.size(), AnalysisUpdate{}.pv.size())),
+    };
+    std::copy_n(info.pv.begin(), update.pv_length, update.pv.begin());
+
+    // a reader that far behind only wants the latest anyway
+    if (not updates.try_push(std::move(update)))
+        LOG_DEBUG("analysis update dropped, queue full");
+
+    if (notify)
+        notify();
+}
+
+void
+Analysis::run(std::stop_token const& token)
+{
+    uint64_t seen = 0;
+    // kept between wake-ups, to start it over if a late cancel cut it short
+    std::optional<Request> latest;
+    bool cut_short = false;
+
+    while (true) {
+        posted.wait(seen, std::memory_order_acquire);
+        seen = posted.load(std::memory_order_acquire);
+
+        cancel.exchange(false, std::memory_order_acq_rel);
+
+        // checked after clearing cancel: the destructor raises it after
+        // asking to stop, so a stop missed here still cancels the search
+        if (token.stop_requested())
+            return;
+
+        // only the newest request matters, the ones before are stale
+        bool fresh = false;
+        while (auto request = requests.try_pop()) {
+            latest = std::move(request);
+            fresh = true;
+        }
+
+        if (not latest or not latest->board or (not fresh and not cut_short))
+            continue;
+
+        auto const& board = *latest->board;
+        auto const id = latest->id;
+
+        SearchLimits const limits{ .stop = &cancel };
+
+        auto const result = search(
+          board,
+          limits,
+          tt,
+          [&](SearchInfo const& info) { publish(id, board, info, false); },
+          latest->previous_positions);
+
+        // a cancel raised during the search is either for a newer request,
+        // already queued, or a late one for this request
+        cut_short = cancel.load(std::memory_order_acquire);
+        publish(id, board, result, not cut_short);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "Pieces.hpp"
+#include "Search.h"
+#include "SpscQueue.hpp"
+#include "TranspositionTable.h"
+
+// result of one finished iteration of the background search
+struct AnalysisUpdate
+{
+    uint64_t request = 0; // what Analysis::analyse returned for the position
+    int depth = 0;
+    int score = 0; // for the player to move, like SearchInfo::score
+    bool turn = Colour::white;
+    uint64_t nodes = 0;
+    bool finished = false; // the search of that position is over
+    uint8_t pv_length = 0;
+    // the start of the principal variation, kept fixed so an update never
+    // allocates on its way through the queue
+    std::array<Move, 16> pv{};
+};
+
+// a search thread fed positions by one other thread, which gets the results
+// back without ever blocking: both directions go through lock-free single
+// producer single consumer queues. Meant for a frame loop asking for hints
+// while it keeps drawing.
+struct Analysis
+{
+    // called on the search thread after each update is queued, so a thread
+    // sleeping on its own events can be woken up to poll()
+    using Notify = std::function<void()>;
+
+    explicit Analysis(std::size_t hash_mb = 16, Notify notify = {});
+
+    // cancels the search and joins the thread
+    ~Analysis();
+
+    Analysis(Analysis const&) = delete;
+    Analysis& operator=(Analysis const&) = delete;
+
+    // the rest is for the owning thread only
+
+    // drops whatever is being searched right away and analyses board until
+    // told otherwise. previous_positions as in search(). Returns the id
+    // updates about this position carry
+    uint64_t analyse(BoardInfo const& board,
+                     std::vector<uint64_t> previous_positions);
+
+    // stops searching, updates queued before may still come out of poll()
+    void stop();
+
+    // next update, oldest first
+    [[nodiscard]] std::optional<AnalysisUpdate> poll()
+    {
+        return updates.try_pop();
+    }
+
+  private:
+    struct Request
+    {
+        uint64_t id = 0;
+        std::optional<BoardInfo> board; // none to just stop
+        std::vector<uint64_t> previous_positions;
+    };
+
+    void post(Request request);
+    void publish(uint64_t request,
+                 BoardInfo const& board,
+                 SearchInfo const& info,
+                 bool finished);
+    void run(std::stop_token const& token);
+
+    TranspositionTable tt;
+    Notify notify;
+
+    SpscQueue<Request, 8> requests;
+    SpscQueue<AnalysisUpdate, 64> updates;
+
+    // raised with every request, the search polls it
+    std::atomic<bool> cancel = false;
+    // requests posted so far, the thread sleeps on it while idle
+    std::atomic<uint64_t> posted = 0;
+    uint64_t next_id = 0;
+
+    // last, so it is joined before anything above goes away
+    std::jthread worker;
+};
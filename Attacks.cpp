@@ -0,0 +1,181 @@
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "Attacks.h"
+
+namespace Attacks {
+
+namespace {
+
+// every blocker configuration of a rook fits in 0x19000 entries and a bishop
+// in 0x1480 once the tables for all squares are packed back to back
+std::array<Bitboard, 0x19000> rook_table;
+std::array<Bitboard, 0x1480> bishop_table;
+
+constexpr auto rook_ways = std::to_array({
+  std::pair{ 0, 1 },
+  { 0, -1 },
+  { 1, 0 },
+  { -1, 0 },
+});
+
+constexpr auto bishop_ways = std::to_array({
+  std::pair{ 1, 1 },
+  { 1, -1 },
+  { -1, -1 },
+  { -1, 1 },
+});
+
+// walks every ray one square at a time, only used to fill the tables
+Bitboard
+sliding_attacks(std::array<std::pair<int, int>, 4> const& ways,
+                int const sq,
+                Bitboard const occupied)
+{
+    Bitboard attacks{};
+
+    for (auto const& [x, y] : ways) {
+        auto file = sq & 7;
+        auto rank = sq >> 3;
+
+        for (;;) {
+            file += x;
+            rank += y;
+
+            if (file < 0 or file >= 8 or rank < 0 or rank >= 8)
+                break;
+
+            auto const b = square_bit(rank * 8 + file);
+            attacks |= b;
+
+            if (occupied & b)
+                break;
+        }
+    }
+
+    return attacks;
+}
+
+// xorshift64*, sparse() returns numbers with few bits set which make good
+// magic candidates
+struct Prng
+{
+    uint64_t s;
+
+    uint64_t next()
+    {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    }
+
+    uint64_t sparse() { return next() & next() & next(); }
+};
+
+bool
+detect_pext()
+{
+#if defined(CHESS_PEXT_ALWAYS)
+    return true;
+#elif defined(CHESS_PEXT_DISPATCH)
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+void
+init_magics(std::array<Magic, 64>& magics,
+            Bitboard* table,
+            std::array<std::pair<int, int>, 4> const& ways)
+{
+    // seeds picked per rank so the search below ends after a few thousand
+    // tries at most, which keeps startup in the milliseconds
+    constexpr auto seeds = std::to_array<uint64_t>(
+      { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 });
+
+    constexpr Bitboard rank_1 = 0xFF;
+    constexpr Bitboard rank_8 = rank_1 << 56;
+    constexpr Bitboard file_a = 0x0101010101010101;
+    constexpr Bitboard file_h = file_a << 7;
+
+    std::vector<Bitboard> occupancies(4096);
+    std::vector<Bitboard> references(4096);
+    std::vector<int> epochs(4096);
+    int attempt = 0;
+
+    for (int sq = 0; sq < 64; ++sq) {
+        auto const rank_mask = rank_1 << (8 * (sq >> 3));
+        auto const file_mask = file_a << (sq & 7);
+
+        // a blocker on the last square of a ray changes nothing
+        auto const edges = ((rank_1 | rank_8) & ~rank_mask) |
+                           ((file_a | file_h) & ~file_mask);
+
+        auto& m = magics[sq];
+        m.mask = sliding_attacks(ways, sq, 0) & ~edges;
+        m.shift = 64 - popcount(m.mask);
+        // each square's slice starts where the previous one ended
+        if (sq == 0) {
+            m.attacks = table;
+        } else {
+            auto const& prev = magics[sq - 1];
+            m.attacks = prev.attacks + (std::size_t{ 1 } << (64 - prev.shift));
+        }
+
+        // enumerate every subset of the mask (carry-rippler)
+        std::size_t size = 0;
+        Bitboard b = 0;
+        do {
+            occupancies[size] = b;
+            references[size] = sliding_attacks(ways, sq, b);
+
+            if (use_pext)
+                m.attacks[index(m, b)] = references[size];
+
+            ++size;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+        if (use_pext)
+            continue;
+
+        Prng prng{ seeds[sq >> 3] };
+
+        // try candidates until every subset either lands on its own slot or
+        // collides with one holding the same attacks
+        for (std::size_t i = 0; i < size;) {
+            for (m.magic = 0; popcount((m.magic * m.mask) >> 56) < 6;)
+                m.magic = prng.sparse();
+
+            ++attempt;
+            for (i = 0; i < size; ++i) {
+                auto const idx = index(m, occupancies[i]);
+
+                if (epochs[idx] < attempt) {
+                    epochs[idx] = attempt;
+                    m.attacks[idx] = references[i];
+                } else if (m.attacks[idx] != references[i]) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+}
+
+std::array<Magic, 64> rook_magics;
+std::array<Magic, 64> bishop_magics;
+bool const use_pext = detect_pext();
+
+// tables are built before main runs, nothing has to remember to call an init
+[[maybe_unused]] static bool const initialised = [] {
+    init_magics(rook_magics, rook_table.data(), rook_ways);
+    init_magics(bishop_magics, bishop_table.data(), bishop_ways);
+    return true;
+}();
+
+};
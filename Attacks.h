@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <utility>
+
+#include "Bitboard.hpp"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define CHESS_PEXT_ALWAYS 1
+#elif defined(__x86_64__) and (defined(__GNUC__) or defined(__clang__))
+#include <immintrin.h>
+#define CHESS_PEXT_DISPATCH 1
+#endif
+
+namespace Attacks {
+
+using Table = std::array<Bitboard, 64>;
+
+// builds, for every square, the mask of the squares reachable with a single
+// jump of one of the given (file, rank) offsets
+template<std::size_t N>
+[[nodiscard]] constexpr Table
+leaper_table(std::array<std::pair<int, int>, N> const& ways)
+{
+    Table table{};
+    for (int sq = 0; sq < 64; ++sq) {
+        for (auto const& [x, y] : ways) {
+            auto const file = (sq & 7) + x;
+            auto const rank = (sq >> 3) + y;
+            if (file >= 0 and file < 8 and rank >= 0 and rank < 8)
+                table[sq] |= square_bit(rank * 8 + file);
+        }
+    }
+    return table;
+}
+
+constexpr Table knight = leaper_table(std::to_array({
+  std::pair{ 1, 2 },
+  { 2, 1 },
+  { 2, -1 },
+  { 1, -2 },
+  { -1, -2 },
+  { -2, -1 },
+  { -2, 1 },
+  { -1, 2 },
+}));
+
+constexpr Table king = leaper_table(std::to_array({
+  std::pair{ 1, 1 },
+  { 1, -1 },
+  { -1, -1 },
+  { -1, 1 },
+  { 0, 1 },
+  { 0, -1 },
+  { 1, 0 },
+  { -1, 0 },
+}));
+
+// squares a pawn of the given colour attacks, indexed [colour][square]
+constexpr std::array<Table, 2> pawn{
+    leaper_table(std::to_array({ std::pair{ 1, 1 }, { -1, 1 } })),
+    leaper_table(std::to_array({ std::pair{ 1, -1 }, { -1, -1 } })),
+};
+
+struct Lines
+{
+    // squares strictly between a and b, empty unless they share a rank, file
+    // or diagonal. Indexed [a][b]
+    std::array<Table, 64> between{};
+    // the whole rank, file or diagonal through a and b, edge to edge, empty
+    // unless they share one. Indexed [a][b]
+    std::array<Table, 64> line{};
+};
+
+constexpr Lines lines = [] {
+    constexpr auto directions = std::to_array({
+      std::pair{ 1, 0 },
+      { -1, 0 },
+      { 0, 1 },
+      { 0, -1 },
+      { 1, 1 },
+      { 1, -1 },
+      { -1, 1 },
+      { -1, -1 },
+    });
+    constexpr auto on_board = [](int const file, int const rank) {
+        return file >= 0 and file < 8 and rank >= 0 and rank < 8;
+    };
+
+    Lines result{};
+    for (int a = 0; a < 64; ++a) {
+        for (auto const& [x, y] : directions) {
+            // both halves of the line, this direction and the opposite one
+            auto full = square_bit(a);
+            for (int s = -1; s <= 1; s += 2)
+                for (int f = (a & 7) + s * x, r = (a >> 3) + s * y;
+                     on_board(f, r);
+                     f += s * x, r += s * y)
+                    full |= square_bit(r * 8 + f);
+
+            Bitboard passed = 0;
+            for (int f = (a & 7) + x, r = (a >> 3) + y; on_board(f, r);
+                 f += x, r += y) {
+                auto const b = r * 8 + f;
+                result.between[a][b] = passed;
+                result.line[a][b] = full;
+                passed |= square_bit(b);
+            }
+        }
+    }
+    return result;
+}();
+
+// sliding attacks are looked up from tables filled in by Attacks.cpp at
+// static initialisation. The blockers on the relevant rays are turned into a
+// table index either with PEXT, when the cpu has BMI2, or with a magic
+// multiply.
+struct Magic
+{
+    Bitboard mask;  // relevant blockers, board edges excluded
+    Bitboard magic; // unused when indexing with PEXT
+    Bitboard* attacks;
+    unsigned shift;
+};
+
+extern std::array<Magic, 64> rook_magics;
+extern std::array<Magic, 64> bishop_magics;
+extern bool const use_pext;
+
+#if defined(CHESS_PEXT_ALWAYS)
+[[nodiscard]] inline uint64_t
+pext(Bitboard const b, Bitboard const mask)
+{
+    return _pext_u64(b, mask);
+}
+#elif defined(CHESS_PEXT_DISPATCH)
+// cannot be inlined into code built without BMI2, it is only ever called
+// once use_pext confirmed the instruction exists
+[[nodiscard]] __attribute__((target("bmi2"))) inline uint64_t
+pext(Bitboard const b, Bitboard const mask)
+{
+    return _pext_u64(b, mask);
+}
+#endif
+
+[[nodiscard]] inline unsigned
+index(Magic const& m, Bitboard const occupied)
+{
+#if defined(CHESS_PEXT_ALWAYS)
+    return static_cast<unsigned>(pext(occupied, m.mask));
+#else
+#if defined(CHESS_PEXT_DISPATCH)
+    if (use_pext)
+        return static_cast<unsigned>(pext(occupied, m.mask));
+#endif
+    return static_cast<unsigned>(((occupied & m.mask) * m.magic) >> m.shift);
+#endif
+}
+
+[[nodiscard]] inline Bitboard
+rook(int const sq, Bitboard const occupied)
+{
+    auto const& m = rook_magics[sq];
+    return m.attacks[index(m, occupied)];
+}
+
+[[nodiscard]] inline Bitboard
+bishop(int const sq, Bitboard const occupied)
+{
+    auto const& m = bishop_magics[sq];
+    return m.attacks[index(m, occupied)];
+}
+
+[[nodiscard]] inline Bitboard
+queen(int const sq, Bitboard const occupied)
+{
+    return rook(sq, occupied) | bishop(sq, occupied);
+}
+
+};
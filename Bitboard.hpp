@@ -0,0 +1,41 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+// one bit per square, squares are numbered a1 = 0, b1 = 1, ..., h8 = 63
+using Bitboard = uint64_t;
+
+[[nodiscard]] constexpr Bitboard
+square_bit(int const sq)
+{
+    return Bitboard{ 1 } << sq;
+}
+
+// every square of a rank, 0 being the first one
+[[nodiscard]] constexpr Bitboard
+rank_mask(int const rank)
+{
+    return Bitboard{ 0xff } << (8 * rank);
+}
+
+[[nodiscard]] constexpr int
+lsb(Bitboard const b)
+{
+    return std::countr_zero(b);
+}
+
+// returns the index of the lowest set bit and clears it
+constexpr int
+pop_lsb(Bitboard& b)
+{
+    auto const sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+[[nodiscard]] constexpr int
+popcount(Bitboard const b)
+{
+    return std::popcount(b);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <string_view>
+
+// an image decoded at build time, w * h pixels of 4 bytes in r, g, b, a
+// order, row after row
+struct EmbeddedImage
+{
+    std::string_view name; // file name without the extension
+    int w, h;
+    unsigned char const* rgba;
+};
+
+// every image of ./assets, written into the build directory by the
+// embed_assets tool
+extern std::span<EmbeddedImage const> const embedded_images;
+
+[[nodiscard]] inline EmbeddedImage const*
+find_embedded_image(std::string_view const name)
+{
+    auto const it =
+      std::ranges::find(embedded_images, name, &EmbeddedImage::name);
+    return it == embedded_images.end() ? nullptr : &*it;
+}
@@ -0,0 +1,116 @@
+#include <array>
+
+#include "Evaluation.h"
+#include "Profile.h"
+
+namespace {
+
+using Table = std::array<int, 64>;
+
+// piece-square bonuses as seen from white, laid out like the board on screen
+// (a8 first, h1 last)
+// clang-format off
+constexpr std::array<Table, PieceType::Count> bonuses{
+    // rook
+    Table{
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+    },
+    // knight
+    Table{
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    },
+    // bishop
+    Table{
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    },
+    // queen
+    Table{
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    },
+    // king, stay behind the pawns while there are pieces around
+    Table{
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+    },
+    // pawn
+    Table{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    },
+};
+// clang-format on
+
+// material and bonus folded together, indexed [colour][type][square]
+constexpr auto values = [] {
+    std::array<std::array<Table, PieceType::Count>, 2> v{};
+
+    for (int type = 0; type < PieceType::Count; ++type) {
+        for (int sq = 0; sq < 64; ++sq) {
+            auto const material = Evaluation::piece_values[type];
+            // tables start from a8, white's squares need the ranks flipped
+            v[Colour::white][type][sq] = material + bonuses[type][sq ^ 56];
+            v[Colour::black][type][sq] = material + bonuses[type][sq];
+        }
+    }
+
+    return v;
+}();
+
+}
+
+int
+evaluate(BoardInfo const& board)
+{
+    PROFILE_ZONE("evaluate");
+
+    int score = 0;
+
+    for (int type = 0; type < PieceType::Count; ++type) {
+        for (auto bb = board.pieces[Colour::white][type]; bb;)
+            score += values[Colour::white][type][pop_lsb(bb)];
+        for (auto bb = board.pieces[Colour::black][type]; bb;)
+            score -= values[Colour::black][type][pop_lsb(bb)];
+    }
+
+    return board.turn == Colour::white ? score : -score;
+}
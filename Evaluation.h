@@ -0,0 +1,15 @@
+#pragma once
+
+#include <array>
+
+#include "Pieces.hpp"
+
+namespace Evaluation {
+// centipawns, indexed by PieceType, the king is never traded so it counts 0
+constexpr auto piece_values = std::to_array({ 500, 320, 330, 900, 0, 100 });
+};
+
+// static evaluation in centipawns, from the point of view of the player to
+// move: material plus a piece-square bonus
+[[nodiscard]] int
+evaluate(BoardInfo const& board);
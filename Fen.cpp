@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Attacks.h"
+#include "Fen.h"
+#include "Logic.h"
+#include "Notation.h"
+
+namespace {
+
+// indexed by PieceType, white in uppercase
+constexpr std::string_view piece_letters = "rnbqkp";
+
+// castling letters in Castling bit order, and the squares the king and rook
+// of each have to stand on
+constexpr std::string_view castling_letters = "KQkq";
+constexpr int8_t castling_king[] = { 4, 4, 60, 60 };  // e1 e1 e8 e8
+constexpr int8_t castling_rook[] = { 7, 0, 63, 56 }; // h1 a1 h8 a8
+
+// next space separated field, empty once there are none left
+std::string_view
+next_field(std::string_view& str)
+{
+    auto const begin = str.find_first_not_of(' ');
+    if (begin == str.npos) {
+        str = {};
+        return {};
+    }
+
+    str.remove_prefix(begin);
+    auto const end = std::min(str.find(' '), str.size());
+    auto const field = str.substr(0, end);
+    str.remove_prefix(end);
+    return field;
+}
+
+bool
+parse_placement(std::string_view const field, BoardInfo& board)
+{
+    int8_t x = 0;
+    int8_t y = 0;
+
+    for (auto const c : field) {
+        if (c == '/') {
+            if (x != 8 or ++y > 7)
+                return false;
+            x = 0;
+        } else if (c >= '1' and c <= '8') {
+            x += c - '0';
+            if (x > 8)
+                return false;
+        } else {
+            auto const lower = static_cast<char>(c | 0x20);
+            auto const type = piece_letters.find(lower);
+            if (type == piece_letters.npos or x > 7)
+                return false;
+
+            board.put(to_square({ x, y }),
+                      c != lower ? Colour::white : Colour::black,
+                      PieceType::PieceType(type));
+            ++x;
+        }
+    }
+
+    return x == 8 and y == 7;
+}
+
+bool
+parse_castling(std::string_view const field, BoardInfo& board)
+{
+    if (field == "-")
+        return true;
+
+    uint8_t rights = 0;
+    for (auto const c : field) {
+        auto const i = castling_letters.find(c);
+        if (i == castling_letters.npos)
+            return false;
+
+        // only kept when the king and rook are where they started
+        bool const colour = i >= 2;
+        if (board.pieces[colour][PieceType::king] &
+                square_bit(castling_king[i]) and
+            board.pieces[colour][PieceType::rook] &
+              square_bit(castling_rook[i]))
+            rights |= uint8_t(1 << i);
+    }
+
+    board.set_castling(rights);
+    return true;
+}
+
+bool
+parse_en_passant(std::string_view const field, BoardInfo& board)
+{
+    if (field == "-")
+        return true;
+
+    if (field.size() != 2 or field[0] < 'a' or field[0] > 'h')
+        return false;
+
+    // on the 6th rank when white is to move, the 3rd otherwise
+    auto const rank = board.turn == Colour::white ? '6' : '3';
+    if (field[1] != rank)
+        return false;
+
+    auto const sq =
+      static_cast<int8_t>((rank - '1') * 8 + (field[0] - 'a'));
+
+    // the pawn that just went past, on an empty square behind it
+    auto const pushed = board.turn == Colour::white ? sq - 8 : sq + 8;
+    if (not(board.pieces[not board.turn][PieceType::pawn] &
+            square_bit(pushed)) or
+        board.mailbox[sq] != -1)
+        return false;
+
+    if (Attacks::pawn[not board.turn][sq] &
+        board.pieces[board.turn][PieceType::pawn])
+        board.set_en_passant(sq);
+
+    return true;
+}
+
+}
+
+std::optional<FenPosition>
+parse_fen(std::string_view fen)
+{
+    FenPosition result{};
+    auto& board = result.board;
+
+    if (not parse_placement(next_field(fen), board))
+        return {};
+
+    auto const turn = next_field(fen);
+    if (turn == "b")
+        board.switch_turn();
+    else if (turn != "w")
+        return {};
+
+    if (not parse_castling(next_field(fen), board) or
+        not parse_en_passant(next_field(fen), board))
+        return {};
+
+    if (auto const clock = next_field(fen); not clock.empty()) {
+        if (not parse_number(clock, board.halfmove_clock))
+            return {};
+
+        auto const fullmove = next_field(fen);
+        if (not fullmove.empty() and
+            not(parse_number(fullmove, result.fullmove) and
+                result.fullmove > 0))
+            return {};
+    }
+
+    if (not next_field(fen).empty())
+        return {};
+
+    using namespace PieceType;
+
+    for (bool const colour : { Colour::white, Colour::black })
+        if (popcount(board.pieces[colour][king]) != 1)
+            return {};
+
+    auto const pawns =
+      board.pieces[Colour::white][pawn] | board.pieces[Colour::black][pawn];
+    if (pawns & (rank_mask(0) | rank_mask(7)))
+        return {};
+
+    if (in_check(board, not board.turn))
+        return {};
+
+    return result;
+}
+
+std::string
+to_fen(BoardInfo const& board, int const fullmove)
+{
+    std::string fen;
+    fen.reserve(90);
+
+    for (int8_t y = 0; y < 8; ++y) {
+        if (y)
+            fen += '/';
+
+        int empty = 0;
+        for (int8_t x = 0; x < 8; ++x) {
+            auto const code = board.mailbox[to_square({ x, y })];
+            if (code == -1) {
+                ++empty;
+                continue;
+            }
+
+            if (empty)
+                fen += static_cast<char>('0' + empty);
+            empty = 0;
+
+            auto const letter = piece_letters[code % PieceType::Count];
+            fen += code >= PieceType::Count ? letter
+                                            : static_cast<char>(letter - 0x20);
+        }
+        if (empty)
+            fen += static_cast<char>('0' + empty);
+    }
+
+    fen += board.turn == Colour::white ? " w " : " b ";
+
+    if (not board.castling)
+        fen += '-';
+    for (std::size_t i = 0; i < castling_letters.size(); ++i)
+        if (board.castling & (1 << i))
+            fen += castling_letters[i];
+
+    if (board.en_passant == -1) {
+        fen += " -";
+    } else {
+        fen += ' ';
+        fen += static_cast<char>('a' + (board.en_passant & 7));
+        fen += static_cast<char>('1' + (board.en_passant >> 3));
+    }
+
+    fen += ' ' + std::to_string(board.halfmove_clock) + ' ' +
+           std::to_string(fullmove);
+    return fen;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Pieces.hpp"
+
+// Forsyth-Edwards Notation, eg. the start:
+// "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+struct FenPosition
+{
+    BoardInfo board;
+    // BoardInfo only keeps the halfmove clock
+    int fullmove = 1;
+};
+
+// placement, turn, castling and en passant, then optionally the halfmove
+// clock and fullmove number (EPD leaves them out). Nothing for anything
+// malformed or a position the move generator can't take: not exactly one
+// king a side, pawns on the first or last rank, the side not to move in
+// check. Castling rights without their king and rook in place are dropped,
+// and so is an en passant square no pawn can take on, as make_move does.
+// No allocation, meant for loading millions of positions.
+[[nodiscard]] std::optional<FenPosition>
+parse_fen(std::string_view fen);
+
+[[nodiscard]] std::string
+to_fen(BoardInfo const& board, int fullmove = 1);
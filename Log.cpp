@@ -0,0 +1,174 @@
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "Log.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// bounded multi producer queue (Vyukov): a slot's sequence says whose turn
+// it is, producers claim slots with a compare exchange on head and the one
+// consumer, the writer thread, follows behind
+constexpr std::size_t capacity = 1024; // power of two
+constexpr std::size_t line_size = 240;
+
+struct Record
+{
+    std::atomic<std::size_t> sequence;
+    Log::Level level;
+    Clock::time_point time;
+    char text[line_size];
+};
+
+struct Logger
+{
+    std::unique_ptr<Record[]> records = std::make_unique<Record[]>(capacity);
+    Clock::time_point const start = Clock::now();
+
+    alignas(64) std::atomic<std::size_t> head = 0;
+    // only the writer thread moves it, read by flush()
+    alignas(64) std::atomic<std::size_t> tail = 0;
+    std::atomic<uint64_t> dropped = 0;
+
+    std::atomic<bool> stopping = false;
+    std::jthread writer;
+
+    Logger()
+    {
+        for (std::size_t i = 0; i < capacity; ++i)
+            records[i].sequence.store(i, std::memory_order_relaxed);
+
+        writer = std::jthread{ [this] { run(); } };
+    }
+
+    ~Logger()
+    {
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+    }
+
+    // the slot to fill, or null when the buffer is full
+    Record* claim()
+    {
+        auto pos = head.load(std::memory_order_relaxed);
+
+        while (true) {
+            auto& record = records[pos & (capacity - 1)];
+            auto const sequence =
+              record.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::intptr_t>(sequence) -
+                              static_cast<std::intptr_t>(pos);
+
+            if (diff == 0) {
+                if (head.compare_exchange_weak(
+                      pos, pos + 1, std::memory_order_relaxed))
+                    return &record;
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void publish(Record& record)
+    {
+        auto const pos = record.sequence.load(std::memory_order_relaxed);
+        record.sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    // writes out whatever is ready, returns whether there was anything
+    bool drain()
+    {
+        auto pos = tail.load(std::memory_order_relaxed);
+        bool any = false;
+
+        while (true) {
+            auto& record = records[pos & (capacity - 1)];
+            if (record.sequence.load(std::memory_order_acquire) != pos + 1)
+                break;
+
+            std::chrono::duration<double> const at = record.time - start;
+            std::fprintf(stderr,
+                         "[%11.6f] %-5s %s\n",
+                         at.count(),
+                         Log::names[record.level],
+                         record.text);
+
+            record.sequence.store(pos + capacity, std::memory_order_release);
+            tail.store(++pos, std::memory_order_release);
+            any = true;
+        }
+
+        if (any)
+            std::fflush(stderr);
+        return any;
+    }
+
+    void run()
+    {
+        using namespace std::chrono_literals;
+
+        while (not stopping.load(std::memory_order_acquire))
+            if (not drain())
+                std::this_thread::sleep_for(1ms);
+
+        drain();
+    }
+};
+
+Logger&
+logger()
+{
+    static Logger instance;
+    return instance;
+}
+
+}
+
+void
+Log::write(Level const level, char const* const format, ...)
+{
+    auto& log = logger();
+
+    auto* const record = log.claim();
+    if (not record) {
+        log.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    record->level = level;
+    record->time = Clock::now();
+
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(record->text, line_size, format, args);
+    va_end(args);
+
+    log.publish(*record);
+}
+
+void
+Log::flush()
+{
+    using namespace std::chrono_literals;
+
+    auto& log = logger();
+    auto const written = log.head.load(std::memory_order_acquire);
+
+    // a line claimed but not published yet is waited for too
+    while (log.tail.load(std::memory_order_acquire) < written)
+        std::this_thread::sleep_for(100us);
+}
+
+uint64_t
+Log::dropped()
+{
+    return logger().dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// levels below CHESS_LOG_LEVEL are compiled out, arguments included, so
+// diagnostics can stay in hot code: 0 trace, 1 debug, 2 info, 3 warn,
+// 4 error, 5 nothing. Set from CMake with -DCHESS_LOG_LEVEL=<name>
+#ifndef CHESS_LOG_LEVEL
+#define CHESS_LOG_LEVEL 2
+#endif
+
+#if defined(__GNUC__) or defined(__clang__)
+#define CHESS_PRINTF_FORMAT(fmt, args)                                         \
+    __attribute__((format(printf, fmt, args)))
+#else
+#define CHESS_PRINTF_FORMAT(fmt, args)
+#endif
+
+namespace Log {
+enum Level
+{
+    trace,
+    debug,
+    info,
+    warn,
+    error,
+    off,
+};
+constexpr auto names =
+  std::to_array({ "trace", "debug", "info", "warn", "error" });
+
+constexpr auto compiled_level = Level(CHESS_LOG_LEVEL);
+
+// formats the line into a lock-free ring buffer that a background thread
+// writes to stderr, the caller never waits on io. When the buffer is full
+// the line is dropped and counted. Meant to be reached through the macros
+// below.
+void
+write(Level level, char const* format, ...) CHESS_PRINTF_FORMAT(2, 3);
+
+// waits until every line written so far reached stderr
+void
+flush();
+
+// lines lost to a full buffer
+[[nodiscard]] uint64_t
+dropped();
+};
+
+#define CHESS_LOG(level, ...)                                                  \
+    do {                                                                       \
+        if constexpr (Log::level >= Log::compiled_level)                       \
+            Log::write(Log::level, __VA_ARGS__);                               \
+    } while (false)
+
+#define LOG_TRACE(...) CHESS_LOG(trace, __VA_ARGS__)
+#define LOG_DEBUG(...) CHESS_LOG(debug, __VA_ARGS__)
+#define LOG_INFO(...) CHESS_LOG(info, __VA_ARGS__)
+#define LOG_WARN(...) CHESS_LOG(warn, __VA_ARGS__)
+#define LOG_ERROR(...) CHESS_LOG(error, __VA_ARGS__)
@@ -1,5 +1,3 @@
-
-#include "SDL.h"
 #include <algorithm>
 #include <array>
 #include <cassert>
@@ -8,391 +6,664 @@
 #include <iostream>
 #include <memory>
 #include <utility>
-#include <vector>
 
+#include "Attacks.h"
+#include "Log.h"
 #include "Logic.h"
 #include "Pieces.hpp"
+#include "Profile.h"
 
 using namespace MoveType;
 
-MoveContainer
-get_moves_rook(Piece const pc, GameData const& game_data)
+namespace {
+
+// everything the generators need to only produce legal moves, worked out
+// once per position instead of playing every move to see if it leaves the
+// king in check
+struct Legality
+{
+    int8_t king = -1; // square of the king of the side moving, -1 if none
+    // enemy pieces giving check
+    Bitboard checkers = 0;
+    // where a piece other than the king has to land: anywhere when not in
+    // check, on the checker or in between it and the king in single check,
+    // nowhere in double check
+    Bitboard check_mask = ~Bitboard{ 0 };
+    // our pieces standing alone between our king and an enemy slider
+    Bitboard pinned = 0;
+
+    // squares the piece on sq may go to as far as checks and pins care
+    [[nodiscard]] Bitboard allowed(int8_t const sq) const
+    {
+        if (pinned & square_bit(sq))
+            return check_mask & Attacks::lines.line[king][sq];
+        return check_mask;
+    }
+};
+
+// pieces of colour `by` attacking the square, with the given blockers
+Bitboard
+attackers(BoardInfo const& board,
+          int8_t const sq,
+          bool const by,
+          Bitboard const occupied)
 {
-    auto const& board = game_data.current_board;
+    using namespace PieceType;
 
-    MoveContainer moves{};
+    auto const& them = board.pieces[by];
 
-    auto ways = std::to_array({
-      std::pair{ 0, 1 },
-      { 0, -1 },
-      { 1, 0 },
-      { -1, 0 },
-    });
+    return (Attacks::pawn[not by][sq] & them[pawn]) |
+           (Attacks::knight[sq] & them[knight]) |
+           (Attacks::king[sq] & them[king]) |
+           (Attacks::bishop(sq, occupied) & (them[bishop] | them[queen])) |
+           (Attacks::rook(sq, occupied) & (them[rook] | them[queen]));
+}
 
-    for (auto const [x, y] : ways) {
-        auto pos{ pc.pos };
+Legality
+legality(BoardInfo const& board, bool const colour)
+{
+    using namespace PieceType;
 
-        for (;;) {
-            pos.y += y;
-            pos.x += x;
+    PROFILE_ZONE("legality");
 
-            if (out_of_bounds(pos))
-                break;
+    Legality info{};
 
-            auto piece = board.peek(pos.x, pos.y);
+    auto const king_bb = board.pieces[colour][king];
+    if (not king_bb)
+        return info;
 
-            bool takes = false;
+    info.king = static_cast<int8_t>(lsb(king_bb));
 
-            if (piece.has_value()) {
-                auto& value = piece.value();
-                // encountered teammate
-                if (value.colour == pc.colour) {
-                    break;
-                    // encountered enemy
-                } else {
-                    moves.push_back({ .where = pos, .move_type = take });
-                    break;
-                }
-                // nothing
-            } else {
-                moves.push_back({ .where = pos, .move_type = move });
-            }
-        }
+    auto const occupied = board.occupied();
+    auto const& them = board.pieces[not colour];
+
+    info.checkers = attackers(board, info.king, not colour, occupied);
+
+    if (popcount(info.checkers) > 1)
+        info.check_mask = 0;
+    else if (info.checkers)
+        info.check_mask =
+          info.checkers |
+          Attacks::lines.between[info.king][lsb(info.checkers)];
+
+    // sliders that would see the king if only enemies blocked them, any of
+    // ours alone in between is pinned
+    auto snipers =
+      (Attacks::rook(info.king, board.occupancy[not colour]) &
+       (them[rook] | them[queen])) |
+      (Attacks::bishop(info.king, board.occupancy[not colour]) &
+       (them[bishop] | them[queen]));
+
+    while (snipers) {
+        auto const blockers =
+          Attacks::lines.between[info.king][pop_lsb(snipers)] & occupied;
+
+        if (popcount(blockers) == 1 and (blockers & board.occupancy[colour]))
+            info.pinned |= blockers;
     }
 
-    return moves;
+    return info;
+}
+
 }
 
-MoveContainer
-get_moves_knight(Piece const pc, GameData const& game_data)
+// turns a mask of destinations into moves, landing on an enemy is a take
+void
+push_targets(int8_t const from,
+             Bitboard targets,
+             Bitboard const enemies,
+             MoveList& moves)
 {
-    MoveContainer moves{};
+    while (targets) {
+        auto const sq = pop_lsb(targets);
+        moves.push_back({
+          .from = to_position(from),
+          .where = to_position(sq),
+          .move_type = (enemies & square_bit(sq)) ? take : move,
+        });
+    }
+}
 
-    auto const& board = game_data.current_board;
+// a pawn landing on the last rank has to promote, queen first so anything
+// picking the first matching move gets the usual choice
+template<Colour::Colour Us>
+void
+push_pawn_move(int8_t const from,
+               int const to,
+               MoveType::MoveType const type,
+               MoveList& moves)
+{
+    constexpr auto last_rank = rank_mask(Us == Colour::white ? 7 : 0);
+
+    if (not(last_rank & square_bit(to))) {
+        moves.push_back({
+          .from = to_position(from),
+          .where = to_position(static_cast<int8_t>(to)),
+          .move_type = type,
+        });
+        return;
+    }
 
-    auto ways = std::to_array({
-      std::pair{ 1, 2 },
-      { 2, 1 },
-      { 2, -1 },
-      { 1, -2 },
-      { -1, -2 },
-      { -2, -1 },
-      { -2, 1 },
-      { -1, 2 },
-    });
+    using namespace Promotion;
+    for (auto const promotion : { queen, rook, bishop, knight })
+        moves.push_back({
+          .from = to_position(from),
+          .where = to_position(static_cast<int8_t>(to)),
+          .move_type = type,
+          .promotion = promotion,
+        });
+}
 
-    for (auto const [x, y] : ways) {
-        auto pos{ pc.pos };
+template<Colour::Colour Us>
+void
+generate_pawns(BoardInfo const& board,
+               Legality const& legal,
+               Bitboard pawns,
+               MoveList& moves)
+{
+    constexpr int up = Us == Colour::white ? 8 : -8;
+    // pos requirement to move 2 upwards
+    constexpr auto start_rank = rank_mask(Us == Colour::white ? 1 : 6);
+
+    auto const empty = ~board.occupied();
+    auto const enemies = board.occupancy[not Us];
+
+    while (pawns) {
+        auto const sq = static_cast<int8_t>(pop_lsb(pawns));
+        auto const allowed = legal.allowed(sq);
+
+        // check one in front, a pawn never stands on the last rank, then
+        // two if it never moved
+        auto const one = sq + up;
+        if (empty & square_bit(one)) {
+            if (allowed & square_bit(one))
+                push_pawn_move<Us>(sq, one, move, moves);
+
+            auto const two = one + up;
+            if ((start_rank & square_bit(sq)) and
+                (empty & allowed & square_bit(two)))
+                moves.push_back({
+                  .from = to_position(sq),
+                  .where = to_position(static_cast<int8_t>(two)),
+                  .move_type = move,
+                });
+        }
 
-        pos.x += x;
-        pos.y += y;
+        // for diagonal takes
+        for (auto targets = Attacks::pawn[Us][sq] & enemies & allowed;
+             targets;)
+            push_pawn_move<Us>(sq, pop_lsb(targets), take, moves);
 
-        if (out_of_bounds(pos))
+        // check en_passant, the board remembers the square a pawn skipped on
+        // its double step
+        if (board.en_passant == -1 or
+            not(Attacks::pawn[Us][sq] & square_bit(board.en_passant)))
             continue;
 
-        auto const piece = board.peek(pos.x, pos.y);
+        auto const taken = board.en_passant - up;
+        auto const ep_bit = square_bit(board.en_passant);
 
-        bool takes = false;
+        // either the pawn taken was checking us or we land in between
+        if (not(legal.check_mask & (ep_bit | square_bit(taken))))
+            continue;
 
-        if (piece.has_value()) {
-            auto& value = piece.value();
-            // encountered enemy
-            if (value.colour != pc.colour) {
-                std::printf("encountered %s %s at %d,%d\n",
-                            Colour::names[value.colour],
-                            PieceType::names[value.type],
-                            value.pos.x,
-                            value.pos.y);
-                moves.push_back({ .where = pos, .move_type = take });
-            }
-            // empty tile
-        } else {
-            moves.push_back({ .where = pos, .move_type = move });
+        // both pawns leave the rank at once, which no pin mask sees, so look
+        // for sliders on the board as it will be, pins included
+        if (legal.king != -1) {
+            using namespace PieceType;
+            auto const& them = board.pieces[not Us];
+            auto const occupied =
+              (board.occupied() ^ square_bit(sq) ^ square_bit(taken)) | ep_bit;
+
+            if ((Attacks::rook(legal.king, occupied) &
+                 (them[rook] | them[queen])) or
+                (Attacks::bishop(legal.king, occupied) &
+                 (them[bishop] | them[queen])))
+                continue;
         }
-    }
 
-    return moves;
+        LOG_TRACE("En passant available");
+        moves.push_back({
+          .from = to_position(sq),
+          .where = to_position(board.en_passant),
+          .move_type = en_passant,
+        });
+    }
 }
 
-MoveContainer
-get_moves_bishop(Piece const pc, GameData const& game_data)
+template<Colour::Colour Us>
+void
+generate_king(BoardInfo const& board,
+              Legality const& legal,
+              Bitboard const king,
+              MoveList& moves)
 {
-    auto const& board = game_data.current_board;
-    MoveContainer moves{};
-
-    auto ways = std::to_array({
-      std::pair{ 1, 1 },
-      { 1, -1 },
-      { -1, -1 },
-      { -1, 1 },
-    });
-
-    for (auto const [x, y] : ways) {
-        auto pos{ pc.pos };
-
-        for (;;) {
-            pos.y += y;
-            pos.x += x;
-
-            if (out_of_bounds(pos))
-                break;
-
-            auto piece = board.peek(pos.x, pos.y);
-
-            bool takes = false;
-
-            if (piece.has_value()) {
-                auto& value = piece.value();
-                // encountered teammate
-                if (value.colour == pc.colour) {
-                    break;
-                    // encountered enemy
-                } else {
-                    moves.push_back({ .where = pos, .move_type = take });
-                    break;
-                }
-                // nothing
-            } else {
-                moves.push_back({ .where = pos, .move_type = move });
-            }
-        }
+    if (not king)
+        return;
+
+    auto const sq = static_cast<int8_t>(lsb(king));
+    // the king must not hide behind itself from a slider checking it
+    auto const occupied = board.occupied() ^ king;
+
+    auto targets = Attacks::king[sq] & ~board.occupancy[Us];
+    for (auto candidates = targets; candidates;) {
+        auto const to = static_cast<int8_t>(pop_lsb(candidates));
+        if (attackers(board, to, not Us, occupied))
+            targets &= ~square_bit(to);
     }
 
-    return moves;
+    push_targets(sq, targets, board.occupancy[not Us], moves);
+
+    // castling, the rights being there means king and rook never moved
+    constexpr int8_t home = Us == Colour::white ? 4 : 60;
+    if (legal.checkers or sq != home)
+        return;
+
+    auto const castle_to = [&](uint8_t const right,
+                               int8_t const rook_sq,
+                               int const step) {
+        auto const passed = static_cast<int8_t>(sq + step);
+        auto const to = static_cast<int8_t>(sq + 2 * step);
+
+        if ((board.castling & right) and
+            not(Attacks::lines.between[sq][rook_sq] & board.occupied()) and
+            not attackers(board, passed, not Us, board.occupied()) and
+            not attackers(board, to, not Us, board.occupied()))
+            moves.push_back({
+              .from = to_position(sq),
+              .where = to_position(to),
+              .move_type = castle,
+            });
+    };
+
+    using namespace Castling;
+    constexpr auto shift = Us == Colour::white ? 0 : 2;
+    castle_to(white_king_side << shift, home + 3, 1);
+    castle_to(white_queen_side << shift, home - 4, -1);
 }
 
-MoveContainer
-get_moves_queen(Piece const pc, GameData const& game_data)
+constexpr auto movegen_zones = std::to_array({ "movegen rook",
+                                                "movegen knight",
+                                                "movegen bishop",
+                                                "movegen queen",
+                                                "movegen king",
+                                                "movegen pawn" });
+
+// moves of every piece of type Type in `pieces`, everything known at
+// compile time is folded away in each of the twelve versions
+template<Colour::Colour Us, PieceType::PieceType Type>
+void
+generate(BoardInfo const& board,
+         Legality const& legal,
+         Bitboard pieces,
+         MoveList& moves)
 {
-    auto const& board = game_data.current_board;
-    MoveContainer moves{};
-
-    // essentially just bishop + rook
-    auto ways = std::to_array({
-      std::pair{ 1, 1 },
-      { 1, -1 },
-      { -1, -1 },
-      { -1, 1 },
-      { 0, 1 },
-      { 0, -1 },
-      { 1, 0 },
-      { -1, 0 },
-    });
-
-    for (auto const [x, y] : ways) {
-        auto pos{ pc.pos };
-
-        for (;;) {
-            pos.y += y;
-            pos.x += x;
-
-            if (out_of_bounds(pos))
-                break;
-
-            auto piece = board.peek(pos.x, pos.y);
-
-            bool takes = false;
-
-            if (piece.has_value()) {
-                auto& value = piece.value();
-                // encountered teammate
-                if (value.colour == pc.colour) {
-                    break;
-                    // encountered enemy
-                } else {
-                    moves.push_back({ .where = pos, .move_type = take });
-                    break;
+    using namespace PieceType;
+
+    PROFILE_ZONE(movegen_zones[Type]);
+
+    if constexpr (Type == pawn) {
+        generate_pawns<Us>(board, legal, pieces, moves);
+    } else if constexpr (Type == king) {
+        generate_king<Us>(board, legal, pieces, moves);
+    } else {
+        auto const occupied = board.occupied();
+        auto const enemies = board.occupancy[not Us];
+
+        while (pieces) {
+            auto const sq = static_cast<int8_t>(pop_lsb(pieces));
+
+            Bitboard attacks;
+            if constexpr (Type == knight)
+                // a pinned knight can never stay on the pin line
+                attacks =
+                  (legal.pinned & square_bit(sq)) ? 0 : Attacks::knight[sq];
+            else if constexpr (Type == bishop)
+                attacks = Attacks::bishop(sq, occupied);
+            else if constexpr (Type == rook)
+                attacks = Attacks::rook(sq, occupied);
+            else // essentially just bishop + rook
+                attacks = Attacks::queen(sq, occupied);
+
+            auto const targets =
+              attacks & ~board.occupancy[Us] & legal.allowed(sq);
+
+            // encountered enemy
+            if constexpr (Log::trace >= Log::compiled_level) {
+                for (auto captures = targets & enemies; captures;) {
+                    auto const value =
+                      board.peek(to_position(pop_lsb(captures))).value();
+                    LOG_TRACE("encountered %s %s at %d,%d",
+                              Colour::names[value.colour],
+                              PieceType::names[value.type],
+                              value.pos.x,
+                              value.pos.y);
                 }
-                // nothing
-            } else {
-                moves.push_back({ .where = pos, .move_type = move });
             }
+
+            push_targets(sq, targets, enemies, moves);
         }
     }
+}
 
-    return moves;
+template<Colour::Colour Us>
+void
+generate_piece(Piece const pc,
+               BoardInfo const& board,
+               Legality const& legal,
+               MoveList& out)
+{
+    using namespace PieceType;
+
+    auto const b = square_bit(to_square(pc.pos));
+
+    switch (pc.type) {
+        case rook: generate<Us, rook>(board, legal, b, out); break;
+        case knight: generate<Us, knight>(board, legal, b, out); break;
+        case bishop: generate<Us, bishop>(board, legal, b, out); break;
+        case queen: generate<Us, queen>(board, legal, b, out); break;
+        case king: generate<Us, king>(board, legal, b, out); break;
+        case pawn: generate<Us, pawn>(board, legal, b, out); break;
+        case Count: break;
+    }
 }
 
-MoveContainer
-get_moves_king(Piece const pc, GameData const& game_data)
+void
+get_moves(Piece const pc, BoardInfo const& board, MoveList& out)
 {
-    auto const& board = game_data.current_board;
-    MoveContainer moves{};
-
-    auto ways = std::to_array({
-      std::pair{ 1, 1 },
-      { 1, -1 },
-      { -1, -1 },
-      { -1, 1 },
-      { 0, 1 },
-      { 0, -1 },
-      { 1, 0 },
-      { -1, 0 },
-    });
-
-    for (auto const [x, y] : ways) {
-        auto pos{ pc.pos };
-
-        pos.x += x;
-        pos.y += y;
-
-        if (out_of_bounds(pos))
-            continue;
+    auto const legal = legality(board, pc.colour);
 
-        auto const piece = board.peek(pos.x, pos.y);
-        std::printf("peeking on %d : %d\n", pos.x, pos.y);
+    if (pc.colour == Colour::white)
+        generate_piece<Colour::white>(pc, board, legal, out);
+    else
+        generate_piece<Colour::black>(pc, board, legal, out);
+}
 
-        bool takes = false;
+bool
+is_attacked(BoardInfo const& board, int8_t const sq, bool const by)
+{
+    return attackers(board, sq, by, board.occupied());
+}
 
-        if (piece.has_value()) {
-            std::printf("there is someone\n");
-            auto const& value = piece.value();
-            // encountered enemy
-            if (value.colour != pc.colour) {
-                moves.push_back({ .where = pos, .move_type = take });
-            }
-        } else { // empty tile
-            std::printf("move on %d : %d\n", pos.x, pos.y);
-            moves.push_back({ .where = pos, .move_type = move });
-        }
-    }
+bool
+in_check(BoardInfo const& board, bool const colour)
+{
+    auto const king = board.pieces[colour][PieceType::king];
+    return king and
+           is_attacked(board, static_cast<int8_t>(lsb(king)), not colour);
+}
+
+template<Colour::Colour Us>
+void
+generate_all(BoardInfo const& board, MoveList& out)
+{
+    using namespace PieceType;
+
+    auto const legal = legality(board, Us);
+    auto const& ours = board.pieces[Us];
+
+    generate<Us, king>(board, legal, ours[king], out);
+
+    // in double check only the king can do something about it
+    if (not legal.check_mask)
+        return;
 
-    return moves;
+    generate<Us, pawn>(board, legal, ours[pawn], out);
+    generate<Us, knight>(board, legal, ours[knight], out);
+    generate<Us, bishop>(board, legal, ours[bishop], out);
+    generate<Us, rook>(board, legal, ours[rook], out);
+    generate<Us, queen>(board, legal, ours[queen], out);
 }
 
-MoveContainer
-get_moves_pawn(Piece const pc, GameData const& game_data)
+template void
+generate_all<Colour::white>(BoardInfo const& board, MoveList& out);
+template void
+generate_all<Colour::black>(BoardInfo const& board, MoveList& out);
+
+void
+get_all_moves(BoardInfo const& board, MoveList& out)
 {
-    auto const& board = game_data.current_board;
-    MoveContainer moves{};
-
-    bool is_obstructed = false;
-
-    int8_t dir;
-    int8_t requirement_2_steps;    // pos requirement to move 2 upwards
-    int8_t requirement_en_passant; // pos requirement to move 2 upwards
-
-    if (pc.colour == Colour::white) {
-        dir = -1; // go up
-        requirement_2_steps = LetterColumn::Y(2);
-        requirement_en_passant = LetterColumn::Y(5);
-    } else { // Colour::black
-        dir = 1;
-        requirement_2_steps = LetterColumn::Y(7);
-        requirement_en_passant = LetterColumn::Y(4);
-    }
+    if (board.turn == Colour::white)
+        generate_all<Colour::white>(board, out);
+    else
+        generate_all<Colour::black>(board, out);
+}
 
-    // check one in front
-    {
-        auto where{ pc.pos };
-        where.y += dir;
-
-        if (out_of_bounds(where)) {
-            // TODO promote pawn
-        } else {
-            auto piece = board.peek(where.x, where.y);
-            if (not piece.has_value()) {
-                moves.push_back({
-                  .where = where,
-                  .move_type = move,
-                });
-            } else {
-                is_obstructed = true;
+namespace {
+
+// castling rights left after something moves from or to a square
+constexpr auto castling_masks = [] {
+    using namespace Castling;
+    using namespace LetterColumn;
+
+    std::array<uint8_t, 64> masks{};
+    masks.fill(all);
+    masks[to_square({ A, Y(1) })] &= ~white_queen_side;
+    masks[to_square({ H, Y(1) })] &= ~white_king_side;
+    masks[to_square({ E, Y(1) })] &= ~(white_king_side | white_queen_side);
+    masks[to_square({ A, Y(8) })] &= ~black_queen_side;
+    masks[to_square({ H, Y(8) })] &= ~black_king_side;
+    masks[to_square({ E, Y(8) })] &= ~(black_king_side | black_queen_side);
+    return masks;
+}();
+
+// where the rook stands and goes when the king castles to `to`
+constexpr std::pair<int8_t, int8_t>
+castling_rook(int8_t const from, int8_t const to)
+{
+    if (to > from) // king side
+        return { static_cast<int8_t>(from + 3), static_cast<int8_t>(from + 1) };
+    else // queen side
+        return { static_cast<int8_t>(from - 4), static_cast<int8_t>(from - 1) };
+}
+
+}
+
+UndoInfo
+make_move(BoardInfo& board, Move const mv)
+{
+    PROFILE_ZONE("make_move");
+
+    auto const from = to_square(mv.from);
+    auto const to = to_square(mv.where);
+    auto const us = board.turn;
+
+    UndoInfo undo{
+        .captured = board.mailbox[to],
+        .en_passant = board.en_passant,
+        .castling = board.castling,
+        .halfmove_clock = board.halfmove_clock,
+    };
+
+    bool const is_pawn = board.pieces[us][PieceType::pawn] & square_bit(from);
+
+    board.set_en_passant(-1);
+
+    switch (mv.move_type) {
+        case move: {
+            board.move(from, to);
+
+            // only worth remembering if an enemy pawn could take it
+            if (is_pawn and (to - from == 16 or from - to == 16)) {
+                auto const skipped = static_cast<int8_t>((from + to) / 2);
+                if (Attacks::pawn[us][skipped] &
+                    board.pieces[not us][PieceType::pawn])
+                    board.set_en_passant(skipped);
             }
-        }
+        } break;
+        case take: {
+            board.remove(to);
+            board.move(from, to);
+        } break;
+        case en_passant: {
+            // the pawn being taken stands next to us, on the square we
+            // passed over
+            auto const taken = to_square({ mv.where.x, mv.from.y });
+            undo.captured = board.mailbox[taken];
+            board.remove(taken);
+            board.move(from, to);
+        } break;
+        case castle: {
+            auto const [rook_from, rook_to] = castling_rook(from, to);
+            board.move(from, to);
+            board.move(rook_from, rook_to);
+        } break;
     }
 
-    // check if you can move 2 steps up
-    if (not is_obstructed and pc.pos.y == requirement_2_steps) {
-        auto where{ pc.pos };
-        where.y += 2 * dir;
-
-        auto piece = board.peek(where.x, where.y);
-        if (not piece.has_value()) {
-            moves.push_back({
-              .where = where,
-              .move_type = move,
-            });
-        }
+    if (mv.promotion != Promotion::none) {
+        board.remove(to);
+        board.put(to, us, Promotion::piece_type(mv.promotion));
     }
 
-    // for diagonal takes
-    for (auto const ways = std::to_array({ Position{ 1, dir }, { -1, dir } });
-         auto const [x, y] : ways) {
-        auto where{ pc.pos };
-        where.y += y;
-        where.x += x;
+    board.set_castling(board.castling & castling_masks[from] &
+                       castling_masks[to]);
 
-        if (out_of_bounds(where))
-            continue;
+    if (is_pawn or undo.captured != -1)
+        board.halfmove_clock = 0;
+    else
+        ++board.halfmove_clock;
 
-        auto const piece = board.peek(where.x, where.y);
-        if (piece.has_value() and piece.value().colour != pc.colour)
-            moves.push_back({
-              .where = where,
-              .move_type = take,
-            });
+    board.switch_turn();
+
+    return undo;
+}
+
+void
+unmake_move(BoardInfo& board, Move const mv, UndoInfo const& undo)
+{
+    PROFILE_ZONE("unmake_move");
+
+    board.switch_turn();
+
+    auto const from = to_square(mv.from);
+    auto const to = to_square(mv.where);
+
+    if (mv.promotion != Promotion::none) {
+        board.remove(to);
+        board.put(to, board.turn, PieceType::pawn);
+    }
+
+    auto const restore = [&board, &undo](int8_t const sq) {
+        board.put(sq,
+                  undo.captured >= PieceType::Count,
+                  PieceType::PieceType(undo.captured % PieceType::Count));
+    };
+
+    switch (mv.move_type) {
+        case move: {
+            board.move(to, from);
+        } break;
+        case take: {
+            board.move(to, from);
+            restore(to);
+        } break;
+        case en_passant: {
+            board.move(to, from);
+            restore(to_square({ mv.where.x, mv.from.y }));
+        } break;
+        case castle: {
+            auto const [rook_from, rook_to] = castling_rook(from, to);
+            board.move(rook_to, rook_from);
+            board.move(to, from);
+        } break;
     }
 
-    // check en_passant
-    if (pc.pos.y == requirement_en_passant) {
-        SDL_Log("Piece fits requirements for en passant\n");
-        for (auto const next_to : { 1, -1 }) {
+    board.set_en_passant(undo.en_passant);
+    board.set_castling(undo.castling);
+    board.halfmove_clock = undo.halfmove_clock;
+}
 
-            auto where{ pc.pos };
-            where.x += next_to;
+void
+GameData::play(Move const mv)
+{
+    if (history.size() % snapshot_interval == 0)
+        snapshots.push_back(current_board);
 
-            if (out_of_bounds(where)) {
-                SDL_Log("en passant not out of bounds\n");
-                continue;
-            }
+    history.push_back(pack_move(mv));
+    (void)make_move(current_board, mv);
+}
 
-            auto const piece = board.peek(where);
+void
+GameData::take_back()
+{
+    // no undo record is kept, the position before is rebuilt instead
+    current_board = position_at(history.size() - 1);
+    history.pop_back();
 
-            if (piece.has_value() and piece.value().type == PieceType::pawn and
-                piece.value().colour != pc.colour) {
-                SDL_Log("There is a pawn next to you, checking if said pawn "
-                        "moved 2 steps last turn");
-                // check if moved twice
-                // this could segfault if no moved happened before getting here
-                auto const& past_state = game_data.history.back();
+    if (history.size() % snapshot_interval == 0)
+        snapshots.pop_back();
+}
 
-                // go two steps up
-                auto const past_piece =
-                  past_state.peek(where.x, where.y + dir * 2);
+BoardInfo
+GameData::position_at(std::size_t const ply) const
+{
+    auto const index = ply / snapshot_interval;
+    if (ply == history.size() or index >= snapshots.size())
+        return current_board;
 
-                if (past_piece.has_value() and
-                    past_piece.value().type == PieceType::pawn) {
+    auto board = snapshots[index];
+    for (auto i = index * snapshot_interval; i < ply; ++i)
+        (void)make_move(board, unpack_move(history[i]));
 
-                    // holds destination y
-                    int8_t y = where.y + dir;
+    return board;
+}
 
-                    SDL_Log("En passant available\n");
-                    moves.push_back({
-                      .where = { where.x, y },
-                      .move_type = en_passant,
-                    });
-                }
-            }
-        }
+std::vector<uint64_t>
+GameData::hashes_before(std::size_t const ply) const
+{
+    std::vector<uint64_t> hashes;
+    hashes.reserve(ply);
+
+    auto board = position_at(0);
+    for (std::size_t i = 0; i < ply; ++i) {
+        hashes.push_back(board.hash);
+        (void)make_move(board, unpack_move(history[i]));
     }
 
-    return moves;
+    return hashes;
 }
 
-[[nodiscard]] MoveContainer
-get_moves(Piece const pc, GameData const& context)
+BoardInfo
+generate_default_game_data()
 {
+    BoardInfo data{};
+    data.set_castling(Castling::all);
 
-    constexpr auto functions = std::to_array({
-      &get_moves_rook,
-      &get_moves_knight,
-      &get_moves_bishop,
-      &get_moves_queen,
-      &get_moves_king,
-      &get_moves_pawn,
-    });
+    using namespace PieceType;
+    using namespace Colour;
+    using namespace LetterColumn;
 
-    return functions[pc.type](pc, context);
-}
+    for (auto const colour : { black, white }) {
+        auto const column = colour == black ? 8 : 1;
+
+        for (int8_t i = 0;
+             auto const type :
+             { rook, knight, bishop, queen, king, bishop, knight, rook }) {
+
+            data.put({
+              .type = type,
+              .pos{ i, Y(column) },
+              .colour = colour,
+            });
+            ++i;
+        }
+    }
 
+    // if i don’t want pawns to test things up i can remove this
+#if 1
+
+    for (auto const colour : { black, white }) {
+        auto const column = colour == black ? 7 : 2;
+
+        for (int8_t i = A; i <= H; ++i) {
+            data.put({
+              .type = pawn,
+              .pos{ i, Y(column) },
+              .colour = colour,
+            });
+        }
+    }
+#endif
+
+    return data;
+}
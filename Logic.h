@@ -2,24 +2,46 @@
 
 #include "Pieces.hpp"
 
-namespace MoveType {
-enum MoveType : uint8_t
+// fixed capacity move container meant to live on the stack, no reachable
+// position has more than 218 moves so 256 is never exceeded
+struct MoveList
 {
-    move,
-    take,
-    en_passant,
-    castle,
-};
-constexpr auto names = std::to_array({ "no", "take", "en_passant", "castle" });
-};
+    static constexpr std::size_t capacity = 256;
 
-struct Move
-{
-    Position where;
-    MoveType::MoveType move_type;
-};
+    // left uninitialised on purpose, only [0, count) is ever read
+    std::array<Move, capacity> moves;
+    std::size_t count = 0;
 
-using MoveContainer = std::vector<Move>;
+    constexpr void push_back(Move const mv) noexcept { moves[count++] = mv; }
+    constexpr void clear() noexcept { count = 0; }
+
+    [[nodiscard]] constexpr std::size_t size() const noexcept { return count; }
+    [[nodiscard]] constexpr bool empty() const noexcept { return count == 0; }
+
+    [[nodiscard]] constexpr Move& operator[](std::size_t i) noexcept
+    {
+        return moves[i];
+    }
+    [[nodiscard]] constexpr Move const& operator[](
+      std::size_t i) const noexcept
+    {
+        return moves[i];
+    }
+
+    [[nodiscard]] constexpr Move* begin() noexcept { return moves.data(); }
+    [[nodiscard]] constexpr Move* end() noexcept
+    {
+        return moves.data() + count;
+    }
+    [[nodiscard]] constexpr Move const* begin() const noexcept
+    {
+        return moves.data();
+    }
+    [[nodiscard]] constexpr Move const* end() const noexcept
+    {
+        return moves.data() + count;
+    }
+};
 
 constexpr bool
 out_of_bounds(Position p)
@@ -27,5 +49,36 @@ out_of_bounds(Position p)
     return p.x >= 8 or p.y >= 8 or p.x < 0 or p.y < 0;
 }
 
-[[nodiscard]] MoveContainer
-get_moves(Piece const pc, GameData const& context);
+// appends the moves of pc to out, out is not cleared first
+void
+get_moves(Piece const pc, BoardInfo const& board, MoveList& out);
+
+// whether any piece of colour `by` attacks the square
+[[nodiscard]] bool
+is_attacked(BoardInfo const& board, int8_t sq, bool by);
+
+// whether the king of colour stands attacked, false if it has no king
+[[nodiscard]] bool
+in_check(BoardInfo const& board, bool colour);
+
+// appends the moves of every piece of Us, who has to be the player to move.
+// Instantiated for both colours in Logic.cpp
+template<Colour::Colour Us>
+void
+generate_all(BoardInfo const& board, MoveList& out);
+
+// generate_all for the player to move
+void
+get_all_moves(BoardInfo const& board, MoveList& out);
+
+// applies a move generated for the player to move and hands the turn over,
+// the returned record is all unmake_move needs to restore the board
+[[nodiscard]] UndoInfo
+make_move(BoardInfo& board, Move const mv);
+
+void
+unmake_move(BoardInfo& board, Move const mv, UndoInfo const& undo);
+
+// the standard starting position, white to move
+[[nodiscard]] BoardInfo
+generate_default_game_data();
@@ -0,0 +1,147 @@
+#include <utility>
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+std::optional<MappedFile>
+MappedFile::open(char const* const path, Access::Access const access)
+{
+    auto const file = CreateFileA(path,
+                                  GENERIC_READ,
+                                  FILE_SHARE_READ,
+                                  nullptr,
+                                  OPEN_EXISTING,
+                                  access == Access::sequential
+                                    ? FILE_FLAG_SEQUENTIAL_SCAN
+                                    : FILE_FLAG_RANDOM_ACCESS,
+                                  nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return {};
+
+    LARGE_INTEGER size{};
+    if (not GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return {};
+    }
+
+    MappedFile mapped;
+    mapped.length = static_cast<std::size_t>(size.QuadPart);
+
+    if (mapped.length) {
+        // the mapping keeps the file open on its own
+        mapped.mapping =
+          CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (not mapped.mapping)
+            return {};
+
+        mapped.bytes = static_cast<char const*>(
+          MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0));
+        if (not mapped.bytes)
+            return {};
+    } else {
+        CloseHandle(file);
+    }
+
+    return mapped;
+}
+
+void
+MappedFile::unmap() noexcept
+{
+    if (bytes)
+        UnmapViewOfFile(bytes);
+    if (mapping)
+        CloseHandle(mapping);
+    bytes = nullptr;
+    mapping = nullptr;
+    length = 0;
+}
+
+#else
+
+std::optional<MappedFile>
+MappedFile::open(char const* const path, Access::Access const access)
+{
+    auto const fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        return {};
+
+    struct stat info
+    {};
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        return {};
+    }
+
+    MappedFile mapped;
+    mapped.length = static_cast<std::size_t>(info.st_size);
+
+    if (mapped.length) {
+        auto* const bytes =
+          mmap(nullptr, mapped.length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (bytes == MAP_FAILED) {
+            close(fd);
+            return {};
+        }
+
+        madvise(bytes,
+                mapped.length,
+                access == Access::sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        mapped.bytes = static_cast<char const*>(bytes);
+    }
+
+    // the mapping stays valid once the descriptor is gone
+    close(fd);
+    return mapped;
+}
+
+void
+MappedFile::unmap() noexcept
+{
+    if (bytes)
+        munmap(const_cast<char*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : bytes{ std::exchange(other.bytes, nullptr) }
+  , length{ std::exchange(other.length, 0) }
+#ifdef _WIN32
+  , mapping{ std::exchange(other.mapping, nullptr) }
+#endif
+{}
+
+MappedFile&
+MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        bytes = std::exchange(other.bytes, nullptr);
+        length = std::exchange(other.length, 0);
+#ifdef _WIN32
+        mapping = std::exchange(other.mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace Access {
+// how the mapping will be read, passed on to the OS as a hint
+enum Access
+{
+    sequential,
+    random,
+};
+};
+
+// a whole file mapped read-only into memory, pages are read in by the OS as
+// they are touched instead of loading the file up front
+struct MappedFile
+{
+    // nothing if the file can't be opened or mapped, an empty file maps to
+    // an empty view
+    [[nodiscard]] static std::optional<MappedFile> open(
+      char const* path,
+      Access::Access access = Access::sequential);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] char const* data() const noexcept { return bytes; }
+    [[nodiscard]] std::size_t size() const noexcept { return length; }
+    [[nodiscard]] std::string_view text() const noexcept
+    {
+        return { bytes, length };
+    }
+
+  private:
+    MappedFile() = default;
+    void unmap() noexcept;
+
+    char const* bytes = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    void* mapping = nullptr; // HANDLE of the file mapping object
+#endif
+};
@@ -0,0 +1,242 @@
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Logic.h"
+#include "Notation.h"
+
+std::string
+to_string(Position const p)
+{
+    return { static_cast<char>('a' + p.x),
+             static_cast<char>('0' + LetterColumn::Y(p.y)) };
+}
+
+namespace {
+
+// indexed by Promotion, lowercase as UCI wants
+constexpr std::string_view promotion_letters = " rnbq";
+
+// indexed by PieceType, pawns have none in SAN
+constexpr std::string_view san_letters = "RNBQK";
+constexpr std::string_view san_promotion_letters = " RNBQ";
+
+[[nodiscard]] PieceType::PieceType
+type_on(BoardInfo const& board, Position const p)
+{
+    return PieceType::PieceType(board.mailbox[to_square(p)] %
+                                PieceType::Count);
+}
+
+}
+
+std::string
+to_string(Move const mv)
+{
+    auto str = to_string(mv.from) + to_string(mv.where);
+    if (mv.promotion != Promotion::none)
+        str += promotion_letters[mv.promotion];
+    return str;
+}
+
+std::optional<Position>
+parse_position(std::string_view const str)
+{
+    if (str.size() < 2 or str[0] < 'a' or str[0] > 'h' or str[1] < '1' or
+        str[1] > '8')
+        return {};
+
+    return Position{ static_cast<int8_t>(str[0] - 'a'),
+                     LetterColumn::Y(static_cast<int8_t>(str[1] - '0')) };
+}
+
+std::optional<Move>
+parse_move(BoardInfo const& board, std::string_view const str)
+{
+    if (str.size() < 4)
+        return {};
+
+    auto const from = parse_position(str.substr(0, 2));
+    auto const where = parse_position(str.substr(2, 2));
+
+    if (not from or not where)
+        return {};
+
+    auto promotion = Promotion::none;
+    if (str.size() > 4) {
+        auto const letter = promotion_letters.find(str[4]);
+        if (letter == 0 or letter == promotion_letters.npos)
+            return {};
+        promotion = Promotion::Promotion(letter);
+    }
+
+    MoveList moves;
+    get_all_moves(board, moves);
+
+    for (auto const mv : moves) {
+        if (mv.from == *from and mv.where == *where and
+            mv.promotion == promotion)
+            return mv;
+    }
+
+    return {};
+}
+
+std::string
+to_san(BoardInfo const& board, Move const mv)
+{
+    std::string san;
+
+    if (mv.move_type == MoveType::castle) {
+        san = mv.where.x > mv.from.x ? "O-O" : "O-O-O";
+    } else {
+        auto const type = type_on(board, mv.from);
+        bool const takes = mv.move_type != MoveType::move;
+
+        if (type == PieceType::pawn) {
+            if (takes)
+                san += static_cast<char>('a' + mv.from.x);
+        } else {
+            san += san_letters[type];
+
+            // other pieces of the kind that can go there too: the file
+            // tells them apart if it can, then the rank, then both
+            MoveList moves;
+            get_all_moves(board, moves);
+
+            bool ambiguous = false, same_file = false, same_rank = false;
+            for (auto const other : moves) {
+                if (other.where != mv.where or other.from == mv.from or
+                    type_on(board, other.from) != type)
+                    continue;
+                ambiguous = true;
+                same_file = same_file or other.from.x == mv.from.x;
+                same_rank = same_rank or other.from.y == mv.from.y;
+            }
+
+            if (ambiguous and (not same_file or same_rank))
+                san += static_cast<char>('a' + mv.from.x);
+            if (ambiguous and same_file)
+                san += to_string(mv.from)[1];
+        }
+
+        if (takes)
+            san += 'x';
+        san += to_string(mv.where);
+
+        if (mv.promotion != Promotion::none) {
+            san += '=';
+            san += san_promotion_letters[mv.promotion];
+        }
+    }
+
+    auto after = board;
+    (void)make_move(after, mv);
+    if (in_check(after, after.turn)) {
+        MoveList replies;
+        get_all_moves(after, replies);
+        san += replies.empty() ? '#' : '+';
+    }
+
+    return san;
+}
+
+std::optional<Move>
+parse_san(BoardInfo const& board, std::string_view str)
+{
+    while (not str.empty() and
+           std::string_view{ "+#!?" }.find(str.back()) != str.npos)
+        str.remove_suffix(1);
+
+    MoveList moves;
+    get_all_moves(board, moves);
+
+    // 0-0 turns up as often as O-O
+    if (str == "O-O" or str == "0-0" or str == "O-O-O" or str == "0-0-0") {
+        bool const king_side = str.size() == 3;
+        for (auto const mv : moves)
+            if (mv.move_type == MoveType::castle and
+                (mv.where.x > mv.from.x) == king_side)
+                return mv;
+        return {};
+    }
+
+    auto type = PieceType::pawn;
+    if (not str.empty()) {
+        auto const letter = san_letters.find(str.front());
+        if (letter != san_letters.npos) {
+            type = PieceType::PieceType(letter);
+            str.remove_prefix(1);
+        }
+    }
+
+    // "e8=Q", also seen as "e8Q"
+    auto promotion = Promotion::none;
+    if (type == PieceType::pawn and not str.empty()) {
+        auto const letter = san_promotion_letters.find(str.back());
+        if (letter != 0 and letter != san_promotion_letters.npos) {
+            promotion = Promotion::Promotion(letter);
+            str.remove_suffix(1);
+            if (not str.empty() and str.back() == '=')
+                str.remove_suffix(1);
+        }
+    }
+
+    if (str.size() < 2)
+        return {};
+    auto const where = parse_position(str.substr(str.size() - 2));
+    if (not where)
+        return {};
+    str.remove_suffix(2);
+
+    if (not str.empty() and str.back() == 'x')
+        str.remove_suffix(1);
+
+    // whatever is left tells pieces apart: a file, a rank or both
+    std::optional<int8_t> file, rank;
+    for (auto const c : str) {
+        if (c >= 'a' and c <= 'h')
+            file = static_cast<int8_t>(c - 'a');
+        else if (c >= '1' and c <= '8')
+            rank = LetterColumn::Y(static_cast<int8_t>(c - '0'));
+        else
+            return {};
+    }
+
+    std::optional<Move> found;
+    for (auto const mv : moves) {
+        if (mv.where != *where or mv.promotion != promotion or
+            type_on(board, mv.from) != type or
+            mv.move_type == MoveType::castle or
+            (file and mv.from.x != *file) or (rank and mv.from.y != *rank))
+            continue;
+        if (found)
+            return {};
+        found = mv;
+    }
+
+    return found;
+}
+
+std::optional<GameData>
+play_moves(std::string_view line)
+{
+    GameData game_data{ .current_board{ generate_default_game_data() },
+                        .history{} };
+
+    while (not line.empty()) {
+        auto const end = line.find(' ');
+        auto const str = line.substr(0, end);
+        line = end == line.npos ? "" : line.substr(end + 1);
+
+        if (str.empty())
+            continue;
+
+        auto const mv = parse_move(game_data.current_board, str);
+        if (not mv)
+            return {};
+        game_data.play(*mv);
+    }
+
+    return game_data;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Logic.h"
+
+// the whole of str as a number: false for an empty string, trailing
+// characters ("10abc") or one out of T's range
+template<typename T>
+[[nodiscard]] bool
+parse_number(std::string_view const str, T& out)
+{
+    auto const [end, ec] =
+      std::from_chars(str.data(), str.data() + str.size(), out);
+    return ec == std::errc{} and end == str.data() + str.size();
+}
+
+// coordinate notation as used by perft tools and UCI, eg.: "e2e4", "e7e8q"
+
+[[nodiscard]] std::string
+to_string(Position const p);
+
+[[nodiscard]] std::string
+to_string(Move const mv);
+
+[[nodiscard]] std::optional<Position>
+parse_position(std::string_view str);
+
+// finds the move of the player to move written as str, if there is one
+[[nodiscard]] std::optional<Move>
+parse_move(BoardInfo const& board, std::string_view str);
+
+// standard algebraic notation as in PGN and EPD, eg.: "Nbd7", "exd6",
+// "e8=Q+", "O-O". mv has to be legal on board
+[[nodiscard]] std::string
+to_san(BoardInfo const& board, Move mv);
+
+// the legal move written as str, check marks and annotations ("+", "#",
+// "!?") are optional and ignored. Nothing if it doesn't name exactly one
+// move
+[[nodiscard]] std::optional<Move>
+parse_san(BoardInfo const& board, std::string_view str);
+
+// the game after playing the space separated moves of line from the start,
+// nothing if one of them is illegal
+[[nodiscard]] std::optional<GameData>
+play_moves(std::string_view line);
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+#include "Logic.h"
+#include "Perft.h"
+#include "Profile.h"
+
+PerftTable::PerftTable(std::size_t const megabytes)
+  : slot_count{ std::bit_floor((std::max<std::size_t>(1, megabytes) << 20) /
+                               sizeof(Slot)) }
+{
+    slots = std::make_unique<Slot[]>(slot_count);
+}
+
+std::optional<uint64_t>
+PerftTable::probe(uint64_t const key, int const depth) const noexcept
+{
+    auto& slot = slots[key & (slot_count - 1)];
+    auto const data =
+      std::atomic_ref{ slot.data }.load(std::memory_order_relaxed);
+    auto const check =
+      std::atomic_ref{ slot.check }.load(std::memory_order_relaxed);
+
+    if ((check ^ data) != key or (data & 0xff) != uint64_t(depth) or
+        data == 0) {
+        PROFILE_COUNT("perft table misses", 1);
+        return {};
+    }
+
+    PROFILE_COUNT("perft table hits", 1);
+    return data >> 8;
+}
+
+void
+PerftTable::store(uint64_t const key,
+                  int const depth,
+                  uint64_t const nodes) noexcept
+{
+    auto& slot = slots[key & (slot_count - 1)];
+    auto const data = nodes << 8 | uint64_t(depth);
+
+    std::atomic_ref{ slot.check }.store(key ^ data, std::memory_order_relaxed);
+    std::atomic_ref{ slot.data }.store(data, std::memory_order_relaxed);
+}
+
+uint64_t
+perft(BoardInfo& board, int const depth)
+{
+    // the position itself, below depth 1 too rather than recursing forever
+    if (depth <= 0)
+        return 1;
+
+    MoveList moves;
+    get_all_moves(board, moves);
+
+    // no need to play the last ply, every generated move is a leaf
+    if (depth == 1)
+        return moves.size();
+
+    uint64_t nodes = 0;
+
+    for (auto const mv : moves) {
+        auto const undo = make_move(board, mv);
+        nodes += perft(board, depth - 1);
+        unmake_move(board, mv, undo);
+    }
+
+    return nodes;
+}
+
+uint64_t
+perft(BoardInfo& board, int const depth, PerftTable& table)
+{
+    // counting the moves is cheaper than a probe
+    if (depth < 2)
+        return perft(board, depth);
+
+    if (auto const nodes = table.probe(board.hash, depth))
+        return *nodes;
+
+    MoveList moves;
+    get_all_moves(board, moves);
+
+    uint64_t nodes = 0;
+
+    for (auto const mv : moves) {
+        auto const undo = make_move(board, mv);
+        nodes += perft(board, depth - 1, table);
+        unmake_move(board, mv, undo);
+    }
+
+    table.store(board.hash, depth, nodes);
+    return nodes;
+}
+
+namespace {
+
+// subtrees this deep or less are walked by a single thread, deeper ones are
+// split into a task per move
+constexpr int serial_depth = 4;
+
+// one line per thread, counts under each root move
+struct alignas(64) Counters
+{
+    std::array<uint64_t, MoveList::capacity> below_root{};
+};
+
+struct Split
+{
+    ThreadPool& pool;
+    PerftTable* table;
+    std::vector<Counters> counters;
+
+    void visit(BoardInfo& board,
+               int const depth,
+               std::size_t const root,
+               std::size_t const worker)
+    {
+        PROFILE_ZONE("perft task");
+
+        auto& count = counters[worker].below_root[root];
+
+        if (depth <= serial_depth) {
+            count += table ? perft(board, depth, *table) : perft(board, depth);
+            return;
+        }
+
+        // split nodes finish in pieces on several threads so they are never
+        // stored, only probed
+        if (table) {
+            if (auto const nodes = table->probe(board.hash, depth)) {
+                count += *nodes;
+                return;
+            }
+        }
+
+        MoveList moves;
+        get_all_moves(board, moves);
+
+        for (auto const mv : moves)
+            submit(board, mv, depth - 1, root);
+    }
+
+    void submit(BoardInfo const& parent,
+                Move const mv,
+                int const depth,
+                std::size_t const root)
+    {
+        auto board = parent;
+        (void)make_move(board, mv);
+
+        pool.submit([this, board, depth, root](std::size_t worker) mutable {
+            visit(board, depth, root, worker);
+        });
+    }
+};
+
+}
+
+std::vector<uint64_t>
+parallel_perft(BoardInfo const& board,
+               int const depth,
+               ThreadPool& pool,
+               PerftTable* const table)
+{
+    MoveList moves;
+    get_all_moves(board, moves);
+
+    Split split{
+        .pool = pool,
+        .table = table,
+        .counters = std::vector<Counters>(pool.size()),
+    };
+
+    for (std::size_t root = 0; root < moves.size(); ++root)
+        split.submit(board, moves[root], depth - 1, root);
+
+    pool.wait();
+
+    std::vector<uint64_t> counts(moves.size());
+    for (auto const& thread : split.counters)
+        for (std::size_t root = 0; root < moves.size(); ++root)
+            counts[root] += thread.below_root[root];
+
+    return counts;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "Pieces.hpp"
+#include "ThreadPool.h"
+
+// leaf counts of positions already walked, shared by every perft thread
+// without locks the same way the transposition table is: a slot torn by two
+// writers fails the key check
+struct PerftTable
+{
+    explicit PerftTable(std::size_t megabytes);
+
+    [[nodiscard]] std::optional<uint64_t> probe(uint64_t key,
+                                                int depth) const noexcept;
+
+    void store(uint64_t key, int depth, uint64_t nodes) noexcept;
+
+  private:
+    struct Slot
+    {
+        uint64_t check; // key ^ data
+        uint64_t data;  // nodes << 8 | depth, 0 while empty
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t slot_count = 0;
+};
+
+// counts the leaf nodes of the move tree, depth plies deep. The board is
+// left as it was found.
+[[nodiscard]] uint64_t
+perft(BoardInfo& board, int depth);
+
+// same, skipping the subtrees already counted in table
+[[nodiscard]] uint64_t
+perft(BoardInfo& board, int depth, PerftTable& table);
+
+// perft split over the pool: subtrees below the root are queued as tasks
+// until they get small enough to be walked by a single thread. Returns the
+// count below every root move, in get_all_moves order. table may be null.
+[[nodiscard]] std::vector<uint64_t>
+parallel_perft(BoardInfo const& board,
+               int depth,
+               ThreadPool& pool,
+               PerftTable* table = nullptr);
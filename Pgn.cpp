@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "Fen.h"
+#include "Log.h"
+#include "Logic.h"
+#include "Notation.h"
+#include "Pgn.h"
+
+namespace {
+
+// chunks are never cut smaller than this, nor left bigger, whatever the
+// number of threads
+constexpr std::size_t min_chunk = std::size_t{ 64 } << 10;
+constexpr std::size_t max_chunk = std::size_t{ 16 } << 20;
+
+constexpr bool
+is_space(char const c)
+{
+    return c == ' ' or c == '\n' or c == '\r' or c == '\t';
+}
+
+// characters that end a move token on top of white space
+constexpr bool
+ends_token(char const c)
+{
+    return is_space(c) or c == '{' or c == '}' or c == '(' or c == ')' or
+           c == ';' or c == '[' or c == ']';
+}
+
+// one of the four result names, nothing for anything else ("?" turns up
+// in Result tags)
+std::optional<GameResult::GameResult>
+parse_result(std::string_view const str)
+{
+    auto const it = std::ranges::find(GameResult::names, str);
+    if (it == GameResult::names.end())
+        return {};
+    return GameResult::GameResult(it - GameResult::names.begin());
+}
+
+// one pass over a piece of text, game after game
+struct Reader
+{
+    std::string_view const text;
+    std::size_t const base; // offset of text in the whole file
+    PgnCallback const& on_game;
+    std::size_t const worker;
+
+    PgnStats stats{};
+    std::size_t pos = 0;
+
+    // the game being read
+    bool in_game = false;
+    bool in_movetext = false;
+    bool failed = false;
+    std::size_t game_begin = 0;
+    std::size_t tags_end = 0;
+    BoardInfo start{};
+    BoardInfo board{};
+    GameResult::GameResult result = GameResult::unknown;
+    std::vector<uint16_t> moves;
+
+    void begin_game()
+    {
+        in_game = true;
+        in_movetext = false;
+        failed = false;
+        game_begin = tags_end = pos;
+        start = board = generate_default_game_data();
+        result = GameResult::unknown;
+        moves.clear();
+    }
+
+    void end_game()
+    {
+        if (not in_game)
+            return;
+        in_game = false;
+
+        if (failed) {
+            ++stats.errors;
+            return;
+        }
+
+        ++stats.games;
+        stats.plies += moves.size();
+
+        on_game({ .offset = base + game_begin,
+                  .tags = text.substr(game_begin, tags_end - game_begin),
+                  .start = start,
+                  .result = result,
+                  .moves = moves },
+                worker);
+    }
+
+    void fail(char const* const why)
+    {
+        if (not failed)
+            LOG_DEBUG("pgn: game at byte %zu skipped, %s",
+                      base + game_begin,
+                      why);
+        failed = true;
+    }
+
+    void skip_past(char const c)
+    {
+        auto const end = text.find(c, pos);
+        pos = end == text.npos ? text.size() : end + 1;
+    }
+
+    // a recursive annotation variation, possibly holding comments and
+    // other variations
+    void skip_variation()
+    {
+        int depth = 0;
+        while (pos < text.size()) {
+            auto const c = text[pos++];
+            if (c == '(')
+                ++depth;
+            else if (c == ')' and --depth == 0)
+                return;
+            else if (c == '{')
+                skip_past('}');
+            else if (c == ';')
+                skip_past('\n');
+        }
+    }
+
+    // [Name "value"], the value may hold escaped quotes
+    void read_tag()
+    {
+        if (in_movetext)
+            end_game();
+        if (not in_game)
+            begin_game();
+
+        ++pos;
+        auto const name_begin = pos;
+        while (pos < text.size() and not is_space(text[pos]) and
+               text[pos] != ']')
+            ++pos;
+        auto const name = text.substr(name_begin, pos - name_begin);
+
+        std::string_view value;
+        auto const quote = text.find('"', pos);
+        auto const close = text.find(']', pos);
+        if (quote != text.npos and quote < close) {
+            auto end = quote + 1;
+            while (end < text.size() and text[end] != '"')
+                end += text[end] == '\\' ? 2 : 1;
+            end = std::min(end, text.size());
+            value = text.substr(quote + 1, end - quote - 1);
+            pos = std::min(end + 1, text.size());
+        }
+        skip_past(']');
+        tags_end = pos;
+
+        if (name == "FEN") {
+            if (auto const position = parse_fen(value))
+                start = board = position->board;
+            else
+                fail("bad FEN tag");
+        } else if (name == "Result") {
+            result = parse_result(value).value_or(GameResult::unknown);
+        }
+    }
+
+    void read_token()
+    {
+        auto const begin = pos;
+        while (pos < text.size() and not ends_token(text[pos]))
+            ++pos;
+        auto token = text.substr(begin, pos - begin);
+
+        if (not in_game)
+            begin_game();
+        in_movetext = true;
+
+        // the result ends the game
+        if (auto const token_result = parse_result(token)) {
+            result = *token_result;
+            end_game();
+            return;
+        }
+
+        // move numbers, "12." or "12...", sometimes glued to the move
+        auto const digits = token.find_first_not_of("0123456789");
+        if (digits != 0 and digits != token.npos and token[digits] == '.') {
+            auto const move = token.find_first_not_of('.', digits);
+            token.remove_prefix(std::min(move, token.size()));
+        }
+        if (token.empty() or failed)
+            return;
+
+        auto const mv = parse_san(board, token);
+        if (not mv) {
+            fail("unreadable or illegal move");
+            return;
+        }
+
+        moves.push_back(pack_move(*mv));
+        (void)make_move(board, *mv);
+    }
+
+    PgnStats run()
+    {
+        while (pos < text.size()) {
+            auto const c = text[pos];
+
+            if (is_space(c))
+                ++pos;
+            else if (c == '[')
+                read_tag();
+            else if (c == '{')
+                skip_past('}');
+            else if (c == ';')
+                skip_past('\n');
+            else if (c == '(')
+                skip_variation();
+            else if (c == '%' and (pos == 0 or text[pos - 1] == '\n'))
+                skip_past('\n');
+            else if (c == '$') {
+                ++pos;
+                while (pos < text.size() and text[pos] >= '0' and
+                       text[pos] <= '9')
+                    ++pos;
+            } else if (c == ')' or c == '}' or c == ']')
+                ++pos;
+            else
+                read_token();
+        }
+
+        end_game();
+        return stats;
+    }
+};
+
+// where the game after pos starts: a tag at the start of a line, right
+// after a blank line or naming the event as the first tag of a game does
+std::size_t
+next_game(std::string_view const text, std::size_t pos)
+{
+    while (true) {
+        pos = text.find("\n[", pos);
+        if (pos == text.npos)
+            return text.size();
+        ++pos;
+
+        auto const before = text.substr(0, pos - 1);
+        bool const blank_before =
+          before.ends_with('\n') or before.ends_with("\n\r");
+        if (blank_before or text.substr(pos).starts_with("[Event "))
+            return pos;
+    }
+}
+
+}
+
+PgnStats
+read_pgn(std::string_view const text,
+         PgnCallback const& on_game,
+         std::size_t const worker)
+{
+    return Reader{
+        .text = text, .base = 0, .on_game = on_game, .worker = worker
+    }
+      .run();
+}
+
+PgnStats
+read_pgn(std::string_view const text,
+         ThreadPool& pool,
+         PgnCallback const& on_game)
+{
+    auto const target =
+      std::clamp(text.size() / (pool.size() * 8), min_chunk, max_chunk);
+
+    struct Chunk
+    {
+        std::size_t begin;
+        std::size_t end;
+        PgnStats stats;
+    };
+    std::vector<Chunk> chunks;
+
+    for (std::size_t begin = 0; begin < text.size();) {
+        auto const end = begin + target >= text.size()
+                           ? text.size()
+                           : next_game(text, begin + target);
+        chunks.push_back({ .begin = begin, .end = end });
+        begin = end;
+    }
+
+    for (auto& chunk : chunks) {
+        pool.submit([&chunk, &text, &on_game](std::size_t const worker) {
+            auto const piece =
+              text.substr(chunk.begin, chunk.end - chunk.begin);
+            chunk.stats = Reader{ .text = piece,
+                                  .base = chunk.begin,
+                                  .on_game = on_game,
+                                  .worker = worker }
+                            .run();
+        });
+    }
+    pool.wait();
+
+    PgnStats total{};
+    for (auto const& chunk : chunks)
+        total += chunk.stats;
+    return total;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
+
+#include "Pieces.hpp"
+#include "ThreadPool.h"
+
+namespace GameResult {
+enum GameResult : uint8_t
+{
+    white_wins,
+    black_wins,
+    draw,
+    unknown,
+};
+constexpr auto names = std::to_array({ "1-0", "0-1", "1/2-1/2", "*" });
+};
+
+// a game as it is handed over. Everything points into the text or the
+// reading thread's buffers, so it is only valid during the call
+struct PgnGame
+{
+    std::size_t offset; // of the game's first byte in the whole text
+    std::string_view tags; // the tag pairs as written, "[Event ...] ..."
+    BoardInfo start; // the standard start unless there was a FEN tag
+    GameResult::GameResult result;
+    std::span<uint16_t const> moves; // pack_move of every ply
+};
+
+struct PgnStats
+{
+    uint64_t games = 0;
+    uint64_t plies = 0;
+    // games skipped for a move that isn't legal or can't be read, or a bad
+    // FEN tag
+    uint64_t errors = 0;
+
+    PgnStats& operator+=(PgnStats const& other) noexcept
+    {
+        games += other.games;
+        plies += other.plies;
+        errors += other.errors;
+        return *this;
+    }
+};
+
+// worker is the index of the calling thread, to keep per thread state
+using PgnCallback =
+  std::function<void(PgnGame const& game, std::size_t worker)>;
+
+// every game of text, in order, on the calling thread. The text is read in
+// place: tags, comments, variations and NAGs are skipped over and each SAN
+// move resolved against the legal moves of the game's current position.
+PgnStats
+read_pgn(std::string_view text,
+         PgnCallback const& on_game,
+         std::size_t worker = 0);
+
+// the same, text cut into chunks at game boundaries that are read in
+// parallel on pool. Games of different chunks are handed over concurrently,
+// in no particular order.
+PgnStats
+read_pgn(std::string_view text, ThreadPool& pool, PgnCallback const& on_game);
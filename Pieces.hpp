@@ -8,6 +8,9 @@
 #include <string_view>
 #include <vector>
 
+#include "Bitboard.hpp"
+#include "Zobrist.hpp"
+
 namespace PieceType {
 enum PieceType
 {
@@ -23,6 +26,27 @@ constexpr auto names =
   std::to_array({ "rook", "knight", "bishop", "queen", "king", "pawn" });
 };
 
+namespace Promotion {
+// what a pawn reaching the last rank becomes, PieceType shifted by one so a
+// Move that leaves it out is not a promotion
+enum Promotion : uint8_t
+{
+    none,
+    rook,
+    knight,
+    bishop,
+    queen,
+};
+constexpr auto names =
+  std::to_array({ "none", "rook", "knight", "bishop", "queen" });
+
+[[nodiscard]] constexpr PieceType::PieceType
+piece_type(Promotion const p)
+{
+    return PieceType::PieceType(p - 1);
+}
+};
+
 namespace LetterColumn {
 // y coordinate is upside down and starts at 1
 constexpr auto Y{ [](int8_t i) -> int8_t { return 8 - i; } };
@@ -41,6 +65,18 @@ enum LetterColumn
 };
 };
 
+namespace Castling {
+// bits of BoardInfo::castling, set while the king and that rook never moved
+enum Castling : uint8_t
+{
+    white_king_side = 1,
+    white_queen_side = 2,
+    black_king_side = 4,
+    black_queen_side = 8,
+    all = 15,
+};
+};
+
 namespace Colour {
 enum Colour : bool
 {
@@ -53,7 +89,7 @@ constexpr auto names = std::to_array({ "white", "black" });
 struct Position
 {
     int8_t x, y;
-    constexpr bool operator==(Position other)
+    constexpr bool operator==(Position other) const
     {
         return other.x == x and other.y == y;
     };
@@ -61,47 +97,210 @@ struct Position
 
 using MoveVector = std::vector<Position>;
 
+// bitboard square index, a1 = 0 and h8 = 63 while Position has y = 0 on the
+// 8th rank
+[[nodiscard]] constexpr int8_t
+to_square(Position const p)
+{
+    return static_cast<int8_t>((7 - p.y) * 8 + p.x);
+}
+
+[[nodiscard]] constexpr Position
+to_position(int8_t const sq)
+{
+    return { static_cast<int8_t>(sq & 7), static_cast<int8_t>(7 - (sq >> 3)) };
+}
+
+namespace MoveType {
+enum MoveType : uint8_t
+{
+    move,
+    take,
+    en_passant,
+    castle,
+};
+constexpr auto names = std::to_array({ "no", "take", "en_passant", "castle" });
+};
+
+struct Move
+{
+    Position from;
+    Position where;
+    MoveType::MoveType move_type;
+    // only set on pawn moves and takes landing on the last rank
+    Promotion::Promotion promotion;
+
+    constexpr bool operator==(Move const& other) const = default;
+};
+
+// 16 bit form of a move for tables and logs: from square in bits 0-5, to
+// square in bits 6-11 and flags in bits 12-15. Flags below 4 are the move
+// type of a move that doesn't promote, a promotion can only be a move or a
+// take so it is 4 + (promotion - 1), plus 4 for takes
+[[nodiscard]] constexpr uint16_t
+pack_move(Move const mv)
+{
+    auto const flags =
+      mv.promotion == Promotion::none
+        ? mv.move_type
+        : 4 + 4 * (mv.move_type == MoveType::take) + mv.promotion - 1;
+
+    return static_cast<uint16_t>(to_square(mv.from) |
+                                 to_square(mv.where) << 6 | flags << 12);
+}
+
+[[nodiscard]] constexpr Move
+unpack_move(uint16_t const packed)
+{
+    auto const flags = packed >> 12;
+    auto const promotes = flags >= 4;
+
+    return {
+        .from = to_position(static_cast<int8_t>(packed & 63)),
+        .where = to_position(static_cast<int8_t>((packed >> 6) & 63)),
+        .move_type = not promotes ? MoveType::MoveType(flags)
+                     : flags >= 8 ? MoveType::take
+                                  : MoveType::move,
+        .promotion = promotes ? Promotion::Promotion((flags & 3) + 1)
+                              : Promotion::none,
+    };
+}
+
+// pieces only exist as bits in BoardInfo, this is the value handed out when
+// looking at a square
 struct Piece
 {
     PieceType::PieceType type;
     Position pos;
     bool colour;
-    bool special; // to be marked as true when the pawn moves two tiles and to
-                  // false at its next move
-    bool alive = true;
 };
 
 struct BoardInfo
 {
-    // this array should only be generated once, all other accesses to the data
-    // should be done through the pointers(array index).
-    std::array<Piece, 32> pieces;
-    std::array<std::array<int8_t, 8>, 8> board;
+    // one mask per colour and piece type, indexed [colour][type]
+    std::array<std::array<Bitboard, PieceType::Count>, 2> pieces{};
+    // every piece of a given colour
+    std::array<Bitboard, 2> occupancy{};
+    // what stands on each square, (colour * PieceType::Count + type) or -1 if
+    // empty, so a single lookup answers "what is there" without scanning the
+    // bitboards
+    std::array<int8_t, 64> mailbox = [] {
+        std::array<int8_t, 64> squares{};
+        squares.fill(-1);
+        return squares;
+    }();
     Colour::Colour turn = Colour::white;
+    // square a pawn can take on en passant, -1 unless the last move was a
+    // double step next to an enemy pawn
+    int8_t en_passant = -1;
+    uint8_t castling = 0; // Castling bits
+    // plies since the last take or pawn move, for the fifty-move rule
+    uint8_t halfmove_clock = 0;
+    // Zobrist key of everything above but the clock, kept up to date by every
+    // function below that changes the position
+    uint64_t hash = 0;
 
     struct PeekResult
     {
-        int8_t idx;
-        Piece* piece;
+        int8_t idx = -1; // square of the piece, -1 if there was none
+        Piece piece;
         // trying to use the same naming as std::optional
         [[nodiscard]] constexpr bool has_value() const { return idx != -1; }
         [[nodiscard]] explicit constexpr operator bool() { return has_value(); }
-        [[nodiscard]] constexpr Piece const& value() const { return *piece; }
-        [[nodiscard]] constexpr Piece& value() { return *piece; }
+        [[nodiscard]] constexpr Piece const& value() const { return piece; }
         constexpr void reset() { idx = -1; }
     };
 
+    [[nodiscard]] constexpr Bitboard occupied() const noexcept
+    {
+        return occupancy[Colour::white] | occupancy[Colour::black];
+    }
+
+    // should only be used on an empty square
+    constexpr void put(int8_t const sq,
+                       bool const colour,
+                       PieceType::PieceType const type) noexcept
+    {
+        auto const b = square_bit(sq);
+        pieces[colour][type] |= b;
+        occupancy[colour] |= b;
+        mailbox[sq] = static_cast<int8_t>(colour * PieceType::Count + type);
+        hash ^= Zobrist::keys.pieces[mailbox[sq]][sq];
+    }
+
+    constexpr void put(Piece const pc) noexcept
+    {
+        put(to_square(pc.pos), pc.colour, pc.type);
+    }
+
+    // removes whatever stands on the square, if anything
+    constexpr void remove(int8_t const sq) noexcept
+    {
+        auto const code = mailbox[sq];
+        if (code == -1)
+            return;
+
+        auto const b = square_bit(sq);
+        bool const colour = code >= PieceType::Count;
+        pieces[colour][code % PieceType::Count] &= ~b;
+        occupancy[colour] &= ~b;
+        mailbox[sq] = -1;
+        hash ^= Zobrist::keys.pieces[code][sq];
+    }
+
     // should only be used to move to an emtpy position
+    constexpr void move(int8_t const from, int8_t const to) noexcept
+    {
+        auto const code = mailbox[from];
+        auto const from_to = square_bit(from) | square_bit(to);
+        bool const colour = code >= PieceType::Count;
+        pieces[colour][code % PieceType::Count] ^= from_to;
+        occupancy[colour] ^= from_to;
+        mailbox[to] = code;
+        mailbox[from] = -1;
+        hash ^=
+          Zobrist::keys.pieces[code][from] ^ Zobrist::keys.pieces[code][to];
+    }
+
+    constexpr void set_en_passant(int8_t const sq) noexcept
+    {
+        if (en_passant != -1)
+            hash ^= Zobrist::keys.en_passant[en_passant & 7];
+        en_passant = sq;
+        if (en_passant != -1)
+            hash ^= Zobrist::keys.en_passant[en_passant & 7];
+    }
+
+    constexpr void set_castling(uint8_t const rights) noexcept
+    {
+        hash ^=
+          Zobrist::keys.castling[castling] ^ Zobrist::keys.castling[rights];
+        castling = rights;
+    }
+
+    // the key from scratch, what hash should always be equal to
+    [[nodiscard]] constexpr uint64_t compute_hash() const noexcept
+    {
+        uint64_t key = 0;
+
+        for (int8_t sq = 0; sq < 64; ++sq)
+            if (mailbox[sq] != -1)
+                key ^= Zobrist::keys.pieces[mailbox[sq]][sq];
+
+        if (turn == Colour::black)
+            key ^= Zobrist::keys.black_to_move;
+        if (en_passant != -1)
+            key ^= Zobrist::keys.en_passant[en_passant & 7];
+
+        return key ^ Zobrist::keys.castling[castling];
+    }
+
     void move(PeekResult pk, Position to)
     {
-        board[to.x][to.y] =
-          pk.idx; // new position is overwritten, it was hopefully empty
-        auto const [x, y] = pk.value().pos;
-        board[x][y] = -1;    // previous position is emptied
-        pk.value().pos = to; // make piece aware of the move
+        move(pk.idx, to_square(to));
     }
 
-    void take(Position enemy_pos) { board[enemy_pos.x][enemy_pos.y] = -1; }
+    void take(Position enemy_pos) { remove(to_square(enemy_pos)); }
 
     // use alternative, will be used as a const way to get access to
     // pieces
@@ -109,11 +308,15 @@ struct BoardInfo
       int8_t const x,
       int8_t const y) const noexcept
     {
-        auto const index = board[x][y];
-        if (index == -1)
+        auto const code = mailbox[to_square({ x, y })];
+        if (code == -1)
             return {};
         else
-            return { pieces[index] };
+            return Piece{
+                .type = PieceType::PieceType(code % PieceType::Count),
+                .pos{ x, y },
+                .colour = code >= PieceType::Count,
+            };
     }
 
     [[nodiscard]] constexpr std::optional<Piece> peek(Position p) const noexcept
@@ -122,25 +325,25 @@ struct BoardInfo
     }
 
     [[nodiscard]] constexpr PeekResult get(int8_t const x,
-                                           int8_t const y) noexcept
+                                           int8_t const y) const noexcept
     {
-        auto const index = board[x][y];
-        if (index == -1)
+        auto const pc = peek(x, y);
+        if (not pc.has_value())
             // access should be prevented by using "has_value()"
-            return { index, nullptr };
+            return { -1, {} };
         else
-            return { index, &pieces[index] };
+            return { to_square({ x, y }), pc.value() };
     }
 
-    [[nodiscard]] constexpr PeekResult get(Position p) noexcept
+    [[nodiscard]] constexpr PeekResult get(Position p) const noexcept
     {
         return get(p.x, p.y);
     }
 
     inline void log() const
     {
-        for (int y = 0; y < 8; ++y) {
-            for (int x = 0; x < 8; ++x) {
+        for (int8_t y = 0; y < 8; ++y) {
+            for (int8_t x = 0; x < 8; ++x) {
                 auto const pc = peek(x, y);
                 if (pc.has_value()) {
                     std::printf("%7s", PieceType::names[pc.value().type]);
@@ -154,17 +357,50 @@ struct BoardInfo
     }
 
     // switches players and returns the current player
-    constexpr bool switch_turn() { return turn = Colour::Colour{ !turn }; }
+    constexpr bool switch_turn()
+    {
+        hash ^= Zobrist::keys.black_to_move;
+        return turn = Colour::Colour{ !turn };
+    }
     constexpr bool opponent() const { return !turn; }
     constexpr bool player() const { return turn; }
 };
 
+// everything make_move overwrites that cannot be deduced from the move itself
+struct UndoInfo
+{
+    int8_t captured; // BoardInfo::mailbox value of the taken piece, or -1
+    int8_t en_passant;
+    uint8_t castling;
+    uint8_t halfmove_clock;
+};
+
+// the game so far as a log of packed moves, two bytes a ply, plus a copy of
+// the board every snapshot_interval plies so that any earlier position is
+// never more than that many moves of replay away
 struct GameData
 {
-    using HistoryContainer = std::vector<BoardInfo>;
+    static constexpr std::size_t snapshot_interval = 32;
+
+    using HistoryContainer = std::vector<uint16_t>;
     BoardInfo current_board;
-    HistoryContainer history{};
+    HistoryContainer history{}; // pack_move of every ply, oldest first
+    // snapshots[i] is the board before history[i * snapshot_interval]
+    std::vector<BoardInfo> snapshots{};
 
-    void save() { history.push_back(current_board); }
-};
+    [[nodiscard]] std::size_t ply_count() const { return history.size(); }
 
+    [[nodiscard]] Move move_at(std::size_t const ply) const
+    {
+        return unpack_move(history[ply]);
+    }
+
+    // all four are defined in Logic.cpp, next to make_move/unmake_move
+    void play(Move mv);
+    void take_back();
+    // the board once the first `ply` moves were played
+    [[nodiscard]] BoardInfo position_at(std::size_t ply) const;
+    // hashes of the boards before each of the first `ply` moves, oldest
+    // first, what search() wants for repetitions
+    [[nodiscard]] std::vector<uint64_t> hashes_before(std::size_t ply) const;
+};
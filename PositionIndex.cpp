@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "Logic.h"
+#include "PositionIndex.h"
+
+namespace {
+
+// bumped whenever the layout of the file changes
+constexpr std::array<char, 8> magic{ 'C', 'H', 'E', 'S', 'S', 'I', 'X', '1' };
+
+struct Header
+{
+    std::array<char, 8> magic;
+    uint64_t count;
+};
+static_assert(sizeof(Header) == 16 and alignof(IndexEntry) <= 16);
+
+// searches this narrow go straight to binary search
+constexpr std::size_t interpolation_cutoff = 32;
+constexpr int max_interpolation_steps = 8;
+
+// entries written, or read back from a spilled run, at once
+constexpr std::size_t write_batch = 4096;
+
+// a thread never spills fewer rows than this, whatever the memory allowed
+constexpr std::size_t min_spill_rows = std::size_t{ 1 } << 16;
+
+// one ply of one game, before they are added up
+struct Row
+{
+    uint64_t hash;
+    uint16_t move;
+    GameResult::GameResult result;
+
+    constexpr auto operator<=>(Row const&) const = default;
+};
+
+constexpr bool
+same_key(IndexEntry const& a, IndexEntry const& b)
+{
+    return a.hash == b.hash and a.move == b.move;
+}
+
+constexpr bool
+key_less(IndexEntry const& a, IndexEntry const& b)
+{
+    return a.hash != b.hash ? a.hash < b.hash : a.move < b.move;
+}
+
+void
+add_results(IndexEntry& to, IndexEntry const& from)
+{
+    for (std::size_t i = 0; i < to.results.size(); ++i)
+        to.results[i] += from.results[i];
+}
+
+// sorted rows of a thread, added up into a run of entries
+std::vector<IndexEntry>
+sum_rows(std::vector<Row>& rows)
+{
+    std::ranges::sort(rows);
+
+    std::vector<IndexEntry> run;
+    for (auto const& row : rows) {
+        IndexEntry const entry{ .hash = row.hash, .move = row.move };
+        if (run.empty() or not same_key(run.back(), entry))
+            run.push_back(entry);
+        ++run.back().results[row.result];
+    }
+
+    rows.clear();
+    return run;
+}
+
+// what a thread gathered, touched by that thread only while games are read
+struct Gatherer
+{
+    std::vector<Row> rows;
+    // its runs written out so far, next to the index
+    std::vector<std::string> spilled;
+    uint64_t positions = 0;
+    bool ok = true;
+
+    // sums the rows into a run and writes it out, to keep the memory of a
+    // build bounded whatever the size of the games
+    void spill(char const* const index_path, std::size_t const worker)
+    {
+        auto const run = sum_rows(rows);
+
+        auto spill_path = std::string{ index_path } + "." +
+                          std::to_string(worker) + "." +
+                          std::to_string(spilled.size()) + ".run";
+        std::unique_ptr<std::FILE, decltype(&std::fclose)> const file{
+            std::fopen(spill_path.c_str(), "wb"), &std::fclose
+        };
+        if (file)
+            spilled.push_back(std::move(spill_path));
+
+        ok = ok and file and
+             std::fwrite(run.data(), sizeof(IndexEntry), run.size(),
+                         file.get()) == run.size() and
+             std::fflush(file.get()) == 0;
+    }
+};
+
+// a sorted run of entries being merged, all in memory or read back from
+// its spilled file a batch at a time
+struct Run
+{
+    std::vector<IndexEntry> buffer;
+    std::size_t at = 0;
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file{ nullptr,
+                                                             &std::fclose };
+
+    // nothing once it is all merged
+    IndexEntry const* head()
+    {
+        if (at == buffer.size() and file) {
+            buffer.resize(write_batch);
+            buffer.resize(std::fread(
+              buffer.data(), sizeof(IndexEntry), write_batch, file.get()));
+            at = 0;
+        }
+        return at < buffer.size() ? &buffer[at] : nullptr;
+    }
+};
+
+// the spilled runs and the index being written, gone once the index is in
+// place or the build failed
+struct TemporaryFiles
+{
+    std::vector<std::string> paths;
+
+    TemporaryFiles() = default;
+    TemporaryFiles(TemporaryFiles const&) = delete;
+    TemporaryFiles& operator=(TemporaryFiles const&) = delete;
+
+    ~TemporaryFiles()
+    {
+        for (auto const& path : paths)
+            std::remove(path.c_str());
+    }
+};
+
+struct Writer
+{
+    std::FILE* file;
+    std::vector<IndexEntry> pending;
+    uint64_t count = 0;
+    bool ok = true;
+
+    void put(IndexEntry const& entry)
+    {
+        pending.push_back(entry);
+        if (pending.size() == write_batch)
+            flush();
+    }
+
+    void flush()
+    {
+        ok = ok and std::fwrite(pending.data(),
+                                sizeof(IndexEntry),
+                                pending.size(),
+                                file) == pending.size();
+        count += pending.size();
+        pending.clear();
+    }
+};
+
+}
+
+std::optional<PositionIndex>
+PositionIndex::open(char const* const path)
+{
+    auto file = MappedFile::open(path, Access::random);
+    if (not file or file->size() < sizeof(Header))
+        return {};
+
+    Header header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (header.magic != magic or
+        (file->size() - sizeof(Header)) / sizeof(IndexEntry) !=
+          header.count or
+        (file->size() - sizeof(Header)) % sizeof(IndexEntry))
+        return {};
+
+    // mappings start on a page, the entries right after the header are
+    // aligned too
+    auto const* const first =
+      reinterpret_cast<IndexEntry const*>(file->data() + sizeof(Header));
+    return PositionIndex{ .file = std::move(*file),
+                          .entries = { first, header.count } };
+}
+
+std::span<IndexEntry const>
+PositionIndex::find(uint64_t const hash) const noexcept
+{
+    // entries below lo are all smaller than hash, the ones from hi on at
+    // least as big
+    std::size_t lo = 0;
+    std::size_t hi = entries.size();
+
+    for (int step = 0;
+         step < max_interpolation_steps and hi - lo > interpolation_cutoff;
+         ++step) {
+        auto const low_key = entries[lo].hash;
+        auto const high_key = entries[hi - 1].hash;
+        if (hash <= low_key) {
+            hi = lo;
+            break;
+        }
+        if (hash > high_key) {
+            lo = hi;
+            break;
+        }
+
+        auto const fraction =
+          double(hash - low_key) / double(high_key - low_key);
+        auto const guess =
+          lo + std::min(std::size_t(fraction * double(hi - 1 - lo)),
+                        hi - 1 - lo);
+        if (entries[guess].hash < hash)
+            lo = guess + 1;
+        else
+            hi = guess;
+    }
+
+    auto const begin = std::lower_bound(
+      entries.begin() + lo,
+      entries.begin() + hi,
+      hash,
+      [](IndexEntry const& entry, uint64_t const key) {
+          return entry.hash < key;
+      });
+    auto end = begin;
+    while (end != entries.end() and end->hash == hash)
+        ++end;
+
+    return { begin, end };
+}
+
+std::optional<IndexBuildStats>
+build_position_index(std::span<std::string_view const> const texts,
+                     char const* const path,
+                     ThreadPool& pool,
+                     std::size_t const max_plies,
+                     std::size_t const memory_mb)
+{
+    // written aside, first of the temporary files, and renamed over path
+    // once complete so a build that fails leaves any index there alone.
+    // Declared before the files, so those are closed by the time these go
+    TemporaryFiles temporary;
+    auto const written = std::string{ path } + ".tmp";
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file{
+        std::fopen(written.c_str(), "wb"), &std::fclose
+    };
+    if (not file)
+        return {};
+    temporary.paths.push_back(written);
+
+    auto const spill_rows = std::max<std::size_t>(
+      (memory_mb << 20) / sizeof(Row) / pool.size(), min_spill_rows);
+
+    IndexBuildStats stats{};
+    std::vector<Gatherer> gatherers(pool.size());
+
+    auto const on_game = [&](PgnGame const& game, std::size_t const worker) {
+        // only the three results have a counter
+        if (game.result > GameResult::draw)
+            return;
+
+        auto& gatherer = gatherers[worker];
+        auto board = game.start;
+        auto const plies = std::min(game.moves.size(), max_plies);
+        for (std::size_t i = 0; i < plies; ++i) {
+            gatherer.rows.push_back({ board.hash, game.moves[i], game.result });
+            (void)make_move(board, unpack_move(game.moves[i]));
+        }
+        gatherer.positions += plies;
+
+        if (gatherer.rows.size() >= spill_rows)
+            gatherer.spill(path, worker);
+    };
+
+    for (auto const text : texts)
+        stats.pgn += read_pgn(text, pool, on_game);
+
+    bool spilled_ok = true;
+    for (auto& gatherer : gatherers) {
+        stats.positions += gatherer.positions;
+        spilled_ok = spilled_ok and gatherer.ok;
+        temporary.paths.insert(temporary.paths.end(),
+                               gatherer.spilled.begin(),
+                               gatherer.spilled.end());
+    }
+    if (not spilled_ok)
+        return {};
+
+    // the rows each thread has left are summed in memory, next to the runs
+    // it spilled
+    std::vector<Run> runs(gatherers.size());
+    for (std::size_t i = 0; i < gatherers.size(); ++i) {
+        pool.submit([&gatherers, &runs, i](std::size_t) {
+            runs[i].buffer = sum_rows(gatherers[i].rows);
+            std::vector<Row>{}.swap(gatherers[i].rows);
+        });
+    }
+    pool.wait();
+
+    for (auto const& spilled : temporary.paths | std::views::drop(1)) {
+        auto& run = runs.emplace_back();
+        run.file.reset(std::fopen(spilled.c_str(), "rb"));
+        if (not run.file)
+            return {};
+    }
+
+    Header const header{ .magic = magic, .count = 0 };
+    Writer writer{ .file = file.get() };
+    writer.ok = std::fwrite(&header, sizeof(header), 1, file.get()) == 1;
+    writer.pending.reserve(write_batch);
+
+    // the smallest head of all runs next, a heap as there is a run for
+    // every spill
+    using Head = std::pair<IndexEntry, std::size_t>;
+    auto const later = [](Head const& a, Head const& b) {
+        return key_less(b.first, a.first);
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> heads{
+        later
+    };
+    for (std::size_t i = 0; i < runs.size(); ++i)
+        if (auto const* const head = runs[i].head())
+            heads.push({ *head, i });
+
+    std::optional<IndexEntry> current;
+    while (not heads.empty()) {
+        auto const [next, i] = heads.top();
+        heads.pop();
+        ++runs[i].at;
+        if (auto const* const head = runs[i].head())
+            heads.push({ *head, i });
+
+        if (current and same_key(*current, next)) {
+            add_results(*current, next);
+        } else {
+            if (current)
+                writer.put(*current);
+            current = next;
+        }
+    }
+    if (current)
+        writer.put(*current);
+    writer.flush();
+
+    for (auto const& run : runs)
+        writer.ok = writer.ok and not(run.file and std::ferror(run.file.get()));
+
+    // the count goes in once it is known
+    Header const done{ .magic = magic, .count = writer.count };
+    writer.ok = writer.ok and std::fseek(file.get(), 0, SEEK_SET) == 0 and
+                std::fwrite(&done, sizeof(done), 1, file.get()) == 1 and
+                std::fclose(file.release()) == 0;
+    if (not writer.ok or std::rename(written.c_str(), path) != 0)
+        return {};
+    temporary.paths.erase(temporary.paths.begin());
+
+    stats.entries = writer.count;
+    return stats;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "MappedFile.h"
+#include "Pgn.h"
+#include "ThreadPool.h"
+
+// what was played from a position across a game collection and how those
+// games ended. The file is a header and then one of these per position and
+// move, sorted by hash then move, in the machine's own byte order, so it is
+// mapped and searched as it is without loading anything.
+
+struct IndexEntry
+{
+    uint64_t hash; // BoardInfo::hash of the position
+    uint16_t move; // pack_move
+    uint16_t reserved = 0;
+    // by GameResult, games without a result aren't indexed
+    std::array<uint32_t, 3> results{};
+
+    [[nodiscard]] constexpr uint64_t games() const noexcept
+    {
+        return uint64_t{ results[0] } + results[1] + results[2];
+    }
+};
+static_assert(sizeof(IndexEntry) == 24);
+
+struct PositionIndex
+{
+    // nothing if the file can't be mapped or isn't an index
+    [[nodiscard]] static std::optional<PositionIndex> open(char const* path);
+
+    // the moves played from the position, by move, empty if no game of the
+    // index reached it. Interpolation search, the hashes being uniform
+    [[nodiscard]] std::span<IndexEntry const> find(
+      uint64_t hash) const noexcept;
+
+    MappedFile file;
+    std::span<IndexEntry const> entries;
+};
+
+struct IndexBuildStats
+{
+    PgnStats pgn{};
+    uint64_t positions = 0; // plies indexed
+    uint64_t entries = 0;   // distinct position and move pairs
+};
+
+// reads the games of every text over pool and writes the index of their
+// first max_plies plies to path. The plies are gathered at 16 bytes each,
+// summed and spilled to sorted runs next to path ("<path>.<thread>.<n>.run")
+// whenever they pass memory_mb, then merged into "<path>.tmp", renamed to
+// path once complete. Those runs take about as much disk as the index.
+// Nothing if a file can't be written, any index already at path is left as
+// it was
+[[nodiscard]] std::optional<IndexBuildStats>
+build_position_index(std::span<std::string_view const> texts,
+                     char const* path,
+                     ThreadPool& pool,
+                     std::size_t max_plies = std::size_t(-1),
+                     std::size_t memory_mb = 1024);
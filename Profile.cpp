@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Profile.h"
+
+namespace {
+
+// events kept per thread for the trace, past that only totals are updated
+constexpr std::size_t max_events = std::size_t{ 1 } << 18;
+
+struct Event
+{
+    uint32_t zone;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct Totals
+{
+    uint64_t calls = 0;
+    uint64_t ns = 0;
+};
+
+// owned by the registry so it outlives its thread, only that thread writes
+// to it
+struct ThreadData
+{
+    std::size_t index;
+    std::vector<Totals> zones;
+    std::vector<uint64_t> counters;
+    std::vector<Event> events;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::string> zones;
+    std::vector<std::string> counters;
+    std::vector<std::unique_ptr<ThreadData>> threads;
+    uint64_t const start = Profile::now_ns();
+};
+
+Registry&
+registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+uint32_t
+id_of(std::vector<std::string>& names, char const* const name)
+{
+    std::lock_guard lock{ registry().mutex };
+
+    auto const it = std::ranges::find(names, name);
+    if (it != names.end())
+        return static_cast<uint32_t>(it - names.begin());
+
+    names.emplace_back(name);
+    return static_cast<uint32_t>(names.size() - 1);
+}
+
+ThreadData&
+this_thread()
+{
+    thread_local ThreadData* data = nullptr;
+
+    if (not data) {
+        auto& r = registry();
+        std::lock_guard lock{ r.mutex };
+        auto const index = r.threads.size();
+        r.threads.push_back(
+          std::make_unique<ThreadData>(ThreadData{ .index = index }));
+        data = r.threads.back().get();
+    }
+
+    return *data;
+}
+
+}
+
+Profile::Zone::Zone(char const* const name)
+  : id{ id_of(registry().zones, name) }
+{}
+
+Profile::Counter::Counter(char const* const name)
+  : id{ id_of(registry().counters, name) }
+{}
+
+void
+Profile::record(uint32_t const zone,
+                uint64_t const start,
+                uint64_t const end) noexcept
+{
+    auto& data = this_thread();
+
+    if (zone >= data.zones.size())
+        data.zones.resize(zone + 1);
+
+    auto& totals = data.zones[zone];
+    ++totals.calls;
+    totals.ns += end - start;
+
+    if (data.events.size() < max_events)
+        data.events.push_back({ .zone = zone, .start = start, .end = end });
+}
+
+void
+Profile::add(uint32_t const counter, uint64_t const n) noexcept
+{
+    auto& data = this_thread();
+
+    if (counter >= data.counters.size())
+        data.counters.resize(counter + 1);
+
+    data.counters[counter] += n;
+}
+
+bool
+Profile::write_chrome_trace(char const* const path)
+{
+    auto& r = registry();
+    std::lock_guard lock{ r.mutex };
+
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> const file{
+        std::fopen(path, "w"), &std::fclose
+    };
+    if (not file)
+        return false;
+
+    auto* const out = file.get();
+    char const* separator = "\n";
+
+    std::fputs("{\"traceEvents\":[", out);
+
+    for (auto const& thread : r.threads) {
+        std::fprintf(out,
+                     "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"tid\":%zu,\"args\":{\"name\":\"thread %zu\"}}",
+                     separator,
+                     thread->index,
+                     thread->index);
+        separator = ",\n";
+
+        for (auto const& e : thread->events) {
+            std::fprintf(out,
+                         ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                         "\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                         r.zones[e.zone].c_str(),
+                         thread->index,
+                         (e.start - r.start) / 1e3,
+                         (e.end - e.start) / 1e3);
+        }
+
+        // counters only have a total, shown as a single sample at the end
+        for (std::size_t i = 0; i < thread->counters.size(); ++i) {
+            std::fprintf(out,
+                         ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,"
+                         "\"tid\":%zu,\"ts\":%.3f,\"args\":{\"count\":%" PRIu64
+                         "}}",
+                         r.counters[i].c_str(),
+                         thread->index,
+                         (now_ns() - r.start) / 1e3,
+                         thread->counters[i]);
+        }
+    }
+
+    std::fputs("\n]}\n", out);
+    return std::ferror(out) == 0;
+}
+
+void
+Profile::write_summary(std::FILE* const out)
+{
+    auto& r = registry();
+    std::lock_guard lock{ r.mutex };
+
+    std::vector<Totals> zones(r.zones.size());
+    std::vector<uint64_t> counters(r.counters.size());
+
+    for (auto const& thread : r.threads) {
+        for (std::size_t i = 0; i < thread->zones.size(); ++i) {
+            zones[i].calls += thread->zones[i].calls;
+            zones[i].ns += thread->zones[i].ns;
+        }
+        for (std::size_t i = 0; i < thread->counters.size(); ++i)
+            counters[i] += thread->counters[i];
+    }
+
+    // most time spent first
+    std::vector<std::size_t> order(zones.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::ranges::sort(order, std::greater{}, [&](std::size_t const i) {
+        return zones[i].ns;
+    });
+
+    std::fprintf(out,
+                 "%-24s %14s %14s %12s\n",
+                 "zone",
+                 "calls",
+                 "total (ms)",
+                 "avg (ns)");
+    for (auto const i : order)
+        std::fprintf(out,
+                     "%-24s %14" PRIu64 " %14.3f %12.1f\n",
+                     r.zones[i].c_str(),
+                     zones[i].calls,
+                     zones[i].ns / 1e6,
+                     zones[i].calls ? double(zones[i].ns) / zones[i].calls
+                                    : 0.0);
+
+    if (counters.empty())
+        return;
+
+    std::fprintf(out, "\n%-24s %14s\n", "counter", "count");
+    for (std::size_t i = 0; i < counters.size(); ++i)
+        std::fprintf(
+          out, "%-24s %14" PRIu64 "\n", r.counters[i].c_str(), counters[i]);
+}
+
+bool
+Profile::report(char const* const trace_path)
+{
+    if (not enabled) {
+        std::fprintf(stderr,
+                     "built without CHESS_PROFILE, nothing was recorded\n");
+        return false;
+    }
+
+    write_summary(stderr);
+
+    if (not write_chrome_trace(trace_path)) {
+        std::fprintf(stderr, "can't write %s\n", trace_path);
+        return false;
+    }
+
+    std::fprintf(stderr, "trace written to %s\n", trace_path);
+    return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// scoped timing zones and event counters for finding where a run spends its
+// time. Everything is recorded per thread without locks, and the macros at
+// the bottom compile to nothing unless CHESS_PROFILE is defined
+// (cmake -DCHESS_PROFILE=ON).
+namespace Profile {
+
+#ifdef CHESS_PROFILE
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+// a named place in the code, registered the first time it is reached. Zones
+// with the same name are merged, so every instantiation of a template shares
+// one
+struct Zone
+{
+    explicit Zone(char const* name);
+    uint32_t id;
+};
+
+struct Counter
+{
+    explicit Counter(char const* name);
+    uint32_t id;
+};
+
+[[nodiscard]] inline uint64_t
+now_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// adds to the zone's totals for this thread and, until the thread has a few
+// hundred thousand of them, keeps the event itself for the trace
+void
+record(uint32_t zone, uint64_t start, uint64_t end) noexcept;
+
+void
+add(uint32_t counter, uint64_t n) noexcept;
+
+// times the enclosing scope
+struct Scope
+{
+    uint32_t const zone;
+    uint64_t const start;
+
+    explicit Scope(Zone const& z) noexcept
+      : zone{ z.id }
+      , start{ now_ns() }
+    {}
+
+    ~Scope() { record(zone, start, now_ns()); }
+
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+};
+
+// both read what every thread recorded, only call them once the threads
+// being measured are done or gone
+
+// chrome://tracing and Perfetto format, returns false if the file can't be
+// written
+bool
+write_chrome_trace(char const* path);
+
+// calls, total and average time of every zone and the counter totals
+void
+write_summary(std::FILE* out);
+
+// what the tools do with --profile: summary on stderr, trace to the file.
+// False, with the reason on stderr, if there is nothing to write or the file
+// can't be written
+bool
+report(char const* trace_path);
+};
+
+#define CHESS_PROFILE_CONCAT_(a, b) a##b
+#define CHESS_PROFILE_CONCAT(a, b) CHESS_PROFILE_CONCAT_(a, b)
+
+#ifdef CHESS_PROFILE
+#define PROFILE_ZONE(name)                                                     \
+    static Profile::Zone const CHESS_PROFILE_CONCAT(profile_zone_,            \
+                                                    __LINE__){ name };         \
+    Profile::Scope const CHESS_PROFILE_CONCAT(profile_scope_, __LINE__)        \
+    {                                                                          \
+        CHESS_PROFILE_CONCAT(profile_zone_, __LINE__)                          \
+    }
+#define PROFILE_COUNT(name, n)                                                 \
+    do {                                                                       \
+        static Profile::Counter const profile_counter{ name };                 \
+        Profile::add(profile_counter.id, n);                                   \
+    } while (false)
+#else
+#define PROFILE_ZONE(name) static_cast<void>(0)
+#define PROFILE_COUNT(name, n) static_cast<void>(0)
+#endif
@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Evaluation.h"
+#include "Logic.h"
+#include "Search.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// mate scores are stored relative to the node so they stay valid when the
+// same position is reached at another ply
+constexpr int
+to_tt(int const score, int const ply)
+{
+    if (score >= Score::mate_bound)
+        return score + ply;
+    if (score <= -Score::mate_bound)
+        return score - ply;
+    return score;
+}
+
+constexpr int
+from_tt(int const score, int const ply)
+{
+    if (score >= Score::mate_bound)
+        return score - ply;
+    if (score <= -Score::mate_bound)
+        return score + ply;
+    return score;
+}
+
+// Lazy SMP: every thread searches the same root on its own board, they only
+// cooperate through the transposition table and this
+struct Shared
+{
+    SearchLimits const& limits;
+    Clock::time_point const start;
+    TranspositionTable& tt;
+
+    // raised by the main thread once the budget is spent or it is done
+    std::atomic<bool> stop = false;
+
+    // per thread node counts, each published by its own thread
+    std::vector<std::atomic<uint64_t>> nodes;
+
+    [[nodiscard]] uint64_t total_nodes() const
+    {
+        uint64_t total = 0;
+        for (auto const& n : nodes)
+            total += n.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    [[nodiscard]] bool out_of_budget() const
+    {
+        if (limits.stop and limits.stop->load(std::memory_order_relaxed))
+            return true;
+        if (limits.nodes and total_nodes() >= limits.nodes)
+            return true;
+        return limits.time.count() and Clock::now() - start >= limits.time;
+    }
+};
+
+// helper threads skip some depths so they are not all searching the same
+// iteration at the same time, thread i (past the main one) searches depth d
+// when ((d + skip_phase[i]) / skip_size[i]) is even
+constexpr auto skip_size = std::to_array(
+  { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 });
+constexpr auto skip_phase = std::to_array(
+  { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 });
+
+struct Worker
+{
+    Shared& shared;
+    std::size_t const id; // 0 is the main thread
+    BoardInfo board;
+    TranspositionTable& tt = shared.tt;
+
+    uint64_t nodes = 0;
+    bool stopped = false;
+
+    // hashes from the start of the game down to the current node
+    std::vector<uint64_t> positions;
+
+    // triangular principal variation table, pv[ply] holds the best line
+    // found from that ply
+    std::array<std::array<Move, Score::max_ply>, Score::max_ply> pv;
+    std::array<int, Score::max_ply> pv_length{};
+
+    // quiet moves that caused a cutoff at each ply, tried right after takes
+    std::array<std::array<std::optional<Move>, 2>, Score::max_ply> killers{};
+
+    void count_node()
+    {
+        ++nodes;
+
+        // the clock is too slow to read at every node, node budgets are
+        // checked at every node to stop right on them when searching alone
+        if ((nodes & 1023) == 0 or (id == 0 and shared.limits.nodes)) {
+            shared.nodes[id].store(nodes, std::memory_order_relaxed);
+
+            if (id == 0 and shared.out_of_budget())
+                shared.stop.store(true, std::memory_order_relaxed);
+        }
+
+        stopped = stopped or shared.stop.load(std::memory_order_relaxed);
+    }
+
+    // the principal variation of the last search from the root
+    [[nodiscard]] std::vector<Move> root_pv() const
+    {
+        return { pv[0].begin(), pv[0].begin() + pv_length[0] };
+    }
+
+    void iterate(int const max_depth)
+    {
+        auto const& size = skip_size[(id - 1) % skip_size.size()];
+        auto const& phase = skip_phase[(id - 1) % skip_phase.size()];
+
+        for (int depth = 1; depth <= max_depth and not stopped; ++depth) {
+            if (((depth + phase) / size) % 2)
+                continue;
+
+            (void)negamax(depth, 0, -Score::infinite, Score::infinite);
+        }
+    }
+
+    [[nodiscard]] bool is_repetition() const
+    {
+        // only positions since the last irreversible move can repeat, and
+        // only with the same player to move
+        auto const size = static_cast<int>(positions.size());
+        auto const oldest = std::max(0, size - 1 - board.halfmove_clock);
+
+        for (int i = size - 3; i >= oldest; i -= 2)
+            if (positions[i] == board.hash)
+                return true;
+
+        return false;
+    }
+
+    [[nodiscard]] UndoInfo play(Move const mv)
+    {
+        auto const undo = make_move(board, mv);
+        positions.push_back(board.hash);
+        return undo;
+    }
+
+    void take_back(Move const mv, UndoInfo const& undo)
+    {
+        positions.pop_back();
+        unmake_move(board, mv, undo);
+    }
+
+    // higher is tried first
+    [[nodiscard]] int order(Move const mv,
+                            std::optional<Move> const& tt_move,
+                            int const ply) const
+    {
+        if (tt_move and mv == *tt_move)
+            return 1'000'000;
+
+        auto const promotion =
+          mv.promotion == Promotion::none
+            ? 0
+            : Evaluation::piece_values[Promotion::piece_type(mv.promotion)];
+
+        if (mv.move_type == MoveType::take or
+            mv.move_type == MoveType::en_passant) {
+            // most valuable victim, least valuable attacker
+            auto const victim =
+              mv.move_type == MoveType::en_passant
+                ? PieceType::pawn
+                : board.mailbox[to_square(mv.where)] % PieceType::Count;
+            auto const attacker =
+              board.mailbox[to_square(mv.from)] % PieceType::Count;
+
+            return 100'000 + 10 * Evaluation::piece_values[victim] -
+                   Evaluation::piece_values[attacker] + promotion;
+        }
+
+        if (promotion)
+            return 100'000 + promotion;
+
+        if (killers[ply][0] and mv == *killers[ply][0])
+            return 90'000;
+        if (killers[ply][1] and mv == *killers[ply][1])
+            return 80'000;
+
+        return 0;
+    }
+
+    // moves the best scored move left in [i, size) to i
+    static void pick(MoveList& moves,
+                     std::array<int, MoveList::capacity>& scores,
+                     std::size_t const i)
+    {
+        auto best = i;
+        for (auto j = i + 1; j < moves.size(); ++j)
+            if (scores[j] > scores[best])
+                best = j;
+
+        std::swap(moves[i], moves[best]);
+        std::swap(scores[i], scores[best]);
+    }
+
+    void update_pv(int const ply, Move const mv)
+    {
+        pv[ply][ply] = mv;
+        for (int i = ply + 1; i < pv_length[ply + 1]; ++i)
+            pv[ply][i] = pv[ply + 1][i];
+        pv_length[ply] = std::max(pv_length[ply + 1], ply + 1);
+    }
+
+    int quiescence(int const ply, int alpha, int const beta)
+    {
+        pv_length[ply] = ply;
+
+        count_node();
+        if (stopped)
+            return 0;
+
+        auto const stand_pat = evaluate(board);
+        if (ply >= Score::max_ply - 1 or stand_pat >= beta)
+            return stand_pat;
+
+        alpha = std::max(alpha, stand_pat);
+        auto best = stand_pat;
+
+        MoveList moves;
+        get_all_moves(board, moves);
+
+        // only takes and queen promotions are looked at, quiet moves are
+        // assumed to not make things worse than standing pat
+        MoveList captures;
+        for (auto const mv : moves)
+            if (mv.move_type == MoveType::take or
+                mv.move_type == MoveType::en_passant or
+                mv.promotion == Promotion::queen)
+                captures.push_back(mv);
+
+        std::array<int, MoveList::capacity> scores;
+        for (std::size_t i = 0; i < captures.size(); ++i)
+            scores[i] = order(captures[i], {}, ply);
+
+        for (std::size_t i = 0; i < captures.size(); ++i) {
+            pick(captures, scores, i);
+            auto const mv = captures[i];
+
+            auto const undo = play(mv);
+            auto const score = -quiescence(ply + 1, -beta, -alpha);
+            take_back(mv, undo);
+
+            if (stopped)
+                return 0;
+
+            if (score > best) {
+                best = score;
+                if (score > alpha) {
+                    alpha = score;
+                    if (alpha >= beta)
+                        break;
+                }
+            }
+        }
+
+        return best;
+    }
+
+    int negamax(int depth, int const ply, int alpha, int const beta)
+    {
+        if (depth <= 0)
+            return quiescence(ply, alpha, beta);
+
+        pv_length[ply] = ply;
+
+        count_node();
+        if (stopped)
+            return 0;
+
+        if (ply > 0 and (board.halfmove_clock >= 100 or is_repetition()))
+            return 0;
+
+        if (ply >= Score::max_ply - 1)
+            return evaluate(board);
+
+        auto const original_alpha = alpha;
+
+        std::optional<Move> tt_move;
+        if (auto const entry = tt.probe(board.hash)) {
+            tt_move = entry->move;
+
+            if (ply > 0 and entry->depth >= depth) {
+                auto const score = from_tt(entry->score, ply);
+
+                if (entry->bound == Bound::exact or
+                    (entry->bound == Bound::lower and score >= beta) or
+                    (entry->bound == Bound::upper and score <= alpha))
+                    return score;
+            }
+        }
+
+        auto const checked = in_check(board, board.turn);
+
+        // don't stop looking in the middle of a forcing sequence
+        if (checked)
+            ++depth;
+
+        MoveList moves;
+        get_all_moves(board, moves);
+
+        if (moves.empty())
+            return checked ? -Score::mate + ply : 0;
+
+        std::array<int, MoveList::capacity> scores;
+        for (std::size_t i = 0; i < moves.size(); ++i)
+            scores[i] = order(moves[i], tt_move, ply);
+
+        int best = -Score::infinite;
+        std::optional<Move> best_move;
+
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            pick(moves, scores, i);
+            auto const mv = moves[i];
+
+            auto const undo = play(mv);
+            auto const score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+            take_back(mv, undo);
+
+            if (stopped)
+                return 0;
+
+            if (score > best) {
+                best = score;
+                best_move = mv;
+
+                if (score > alpha) {
+                    alpha = score;
+                    update_pv(ply, mv);
+
+                    if (alpha >= beta) {
+                        if (mv.move_type == MoveType::move and
+                            mv.promotion == Promotion::none and
+                            not(killers[ply][0] and mv == *killers[ply][0])) {
+                            killers[ply][1] = killers[ply][0];
+                            killers[ply][0] = mv;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+
+        auto const bound = best >= beta               ? Bound::lower
+                           : best > original_alpha ? Bound::exact
+                                                   : Bound::upper;
+
+        tt.store(board.hash,
+                 {
+                   .move = best_move,
+                   .score = static_cast<int16_t>(to_tt(best, ply)),
+                   .depth = static_cast<int8_t>(depth),
+                   .bound = bound,
+                 });
+
+        return best;
+    }
+};
+
+}
+
+std::string
+format_score(int const score)
+{
+    if (Score::is_mate(score))
+        return "mate " + std::to_string(Score::mate_in(score));
+    return "cp " + std::to_string(score);
+}
+
+SearchInfo
+search(BoardInfo const& board,
+       SearchLimits const& limits,
+       TranspositionTable& tt,
+       InfoCallback const& on_iteration,
+       std::span<uint64_t const> const previous_positions)
+{
+    tt.new_search();
+
+    auto const threads = static_cast<std::size_t>(std::max(1, limits.threads));
+
+    Shared shared{
+        .limits = limits,
+        .start = Clock::now(),
+        .tt = tt,
+        .nodes = std::vector<std::atomic<uint64_t>>(threads),
+    };
+
+    // each worker owns a pv table of a few hundred kilobytes, better not
+    // kept on the stack
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (std::size_t id = 0; id < threads; ++id) {
+        workers.push_back(std::make_unique<Worker>(Worker{
+          .shared = shared,
+          .id = id,
+          .board = board,
+        }));
+
+        auto& positions = workers.back()->positions;
+        positions.reserve(previous_positions.size() + Score::max_ply);
+        positions.assign(previous_positions.begin(), previous_positions.end());
+        positions.push_back(board.hash);
+    }
+
+    auto const max_depth = std::clamp(limits.depth, 1, Score::max_ply - 1);
+
+    std::vector<std::jthread> helpers;
+    for (std::size_t id = 1; id < threads; ++id)
+        helpers.emplace_back(
+          [&worker = *workers[id], max_depth] { worker.iterate(max_depth); });
+
+    auto& worker = *workers.front();
+    SearchInfo result{};
+
+    // something to play even when stopped before depth 1 finished a root
+    // move: the hash move if it is legal here, or else the first legal one
+    MoveList legal;
+    get_all_moves(board, legal);
+    if (not legal.empty()) {
+        auto const entry = tt.probe(board.hash);
+        auto const hash_move =
+          entry and entry->move and std::ranges::count(legal, *entry->move)
+            ? *entry->move
+            : legal.moves[0];
+        result.pv = { hash_move };
+    }
+
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        auto const score =
+          worker.negamax(depth, 0, -Score::infinite, Score::infinite);
+
+        // an interrupted iteration is only better than nothing, and it is
+        // nothing until it finished a root move
+        if (worker.stopped and (depth > 1 or worker.root_pv().empty()))
+            break;
+
+        shared.nodes[0].store(worker.nodes, std::memory_order_relaxed);
+        auto const nodes = shared.total_nodes();
+        auto const elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                                shared.start);
+
+        result = {
+            .depth = depth,
+            .score = score,
+            .nodes = nodes,
+            .elapsed = elapsed,
+            .nps = nodes * 1000 / std::max<uint64_t>(1, elapsed.count()),
+            .pv = worker.root_pv(),
+        };
+
+        if (worker.stopped)
+            break;
+
+        if (on_iteration)
+            on_iteration(result);
+
+        // no deeper search will find a shorter mate than one already seen
+        if (Score::is_mate(score) and
+            Score::mate - std::abs(score) <= depth)
+            break;
+    }
+
+    // the helpers only ever stop on this
+    shared.stop.store(true, std::memory_order_relaxed);
+
+    return result;
+}
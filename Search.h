@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Pieces.hpp"
+#include "TranspositionTable.h"
+
+namespace Score {
+constexpr int infinite = 32001;
+constexpr int mate = 32000;
+// deepest ply the search can reach, quiescence included
+constexpr int max_ply = 128;
+// scores past this are mates found max_ply plies away or less
+constexpr int mate_bound = mate - max_ply;
+
+[[nodiscard]] constexpr bool
+is_mate(int const score)
+{
+    return score >= mate_bound or score <= -mate_bound;
+}
+
+// moves until mate, negative when the player to move is getting mated
+[[nodiscard]] constexpr int
+mate_in(int const score)
+{
+    return score > 0 ? (mate - score + 1) / 2 : -(mate + score) / 2;
+}
+};
+
+// "cp N" or "mate N", as the tools print scores
+[[nodiscard]] std::string
+format_score(int score);
+
+struct SearchLimits
+{
+    int depth = Score::max_ply / 2;
+    uint64_t nodes = 0;                  // 0 for no limit
+    std::chrono::milliseconds time{ 0 }; // 0 for no limit
+    // raised from another thread to end the search as soon as possible
+    std::atomic<bool> const* stop = nullptr;
+    // threads searching together, sharing the transposition table
+    int threads = 1;
+};
+
+// state of the search after a finished iteration
+struct SearchInfo
+{
+    int depth = 0;
+    int score = 0; // centipawns or Score::mate - plies, for the player to move
+    uint64_t nodes = 0;
+    std::chrono::milliseconds elapsed{ 0 };
+    uint64_t nps = 0;
+    std::vector<Move> pv; // best move first, empty if there is no move
+};
+
+using InfoCallback = std::function<void(SearchInfo const&)>;
+
+// iterative deepening negamax alpha-beta with quiescence on captures. Calls
+// on_iteration after every completed depth of the main thread and returns the
+// last one, cut short iterations are thrown away. With more than one thread,
+// helpers search the same position at staggered depths to fill the
+// transposition table for the main thread (Lazy SMP).
+// previous_positions are the hashes of the positions played before this one,
+// oldest first, for repetition detection.
+[[nodiscard]] SearchInfo
+search(BoardInfo const& board,
+       SearchLimits const& limits,
+       TranspositionTable& tt,
+       InfoCallback const& on_iteration = {},
+       std::span<uint64_t const> previous_positions = {});
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+// bounded lock-free queue between exactly one producer thread and one
+// consumer thread. Each side owns one index and only reads the other's, so
+// neither ever waits: push fails when full, pop when empty.
+template<typename T, std::size_t Capacity>
+struct SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "capacity has to be a power of two");
+
+    // producer side, value is only moved from when it goes in, so a failed
+    // push can be retried with it
+    [[nodiscard]] bool try_push(T&& value)
+    {
+        auto const h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        slots[h & (Capacity - 1)] = std::move(value);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    [[nodiscard]] std::optional<T> try_pop()
+    {
+        auto const t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return {};
+
+        std::optional<T> value{ std::move(slots[t & (Capacity - 1)]) };
+        tail.store(t + 1, std::memory_order_release);
+        return value;
+    }
+
+  private:
+    std::array<T, Capacity> slots{};
+
+    // both only ever grow, the slot is the index modulo Capacity
+    alignas(64) std::atomic<std::size_t> head = 0; // next slot to write
+    alignas(64) std::atomic<std::size_t> tail = 0; // next slot to read
+};
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <utility>
+
+#include "ThreadPool.h"
+
+namespace {
+
+// set on the pool's own threads, so submit() knows which queue is theirs
+thread_local ThreadPool const* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+
+}
+
+ThreadPool::ThreadPool(std::size_t const count)
+{
+    auto const n = std::max<std::size_t>(1, count);
+
+    for (std::size_t i = 0; i < n; ++i)
+        queues.push_back(std::make_unique<Queue>());
+
+    threads.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        threads.emplace_back([this, i] { run(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock{ sleep_mutex };
+        stopping = true;
+    }
+    work_available.notify_all();
+    threads.clear();
+}
+
+void
+ThreadPool::submit(Task task)
+{
+    auto const worker = current_pool == this
+                          ? current_worker
+                          : next_queue.fetch_add(1, std::memory_order_relaxed) %
+                              queues.size();
+
+    pending.fetch_add(1, std::memory_order_relaxed);
+    queued.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard lock{ queues[worker]->mutex };
+        queues[worker]->tasks.push_back(std::move(task));
+    }
+
+    // taking the lock makes sure a thread about to sleep sees the task
+    {
+        std::lock_guard lock{ sleep_mutex };
+    }
+    work_available.notify_one();
+}
+
+void
+ThreadPool::wait()
+{
+    std::unique_lock lock{ sleep_mutex };
+    all_done.wait(lock, [this] {
+        return pending.load(std::memory_order_acquire) == 0;
+    });
+}
+
+bool
+ThreadPool::try_pop(std::size_t const worker, Task& task)
+{
+    auto& queue = *queues[worker];
+    std::lock_guard lock{ queue.mutex };
+
+    if (queue.tasks.empty())
+        return false;
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool
+ThreadPool::try_steal(std::size_t const worker, Task& task)
+{
+    for (std::size_t i = 1; i < queues.size(); ++i) {
+        auto& queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard lock{ queue.mutex };
+
+        if (queue.tasks.empty())
+            continue;
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    return false;
+}
+
+void
+ThreadPool::run(std::size_t const worker)
+{
+    current_pool = this;
+    current_worker = worker;
+
+    Task task;
+
+    while (true) {
+        if (try_pop(worker, task) or try_steal(worker, task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            task(worker);
+            task = nullptr;
+
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard lock{ sleep_mutex };
+                all_done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock lock{ sleep_mutex };
+        work_available.wait(lock, [this] {
+            return stopping or queued.load(std::memory_order_acquire) != 0;
+        });
+
+        if (stopping)
+            return;
+    }
+}
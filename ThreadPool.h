@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of threads, each with its own queue of tasks. A thread runs the
+// newest task of its own queue first, tasks queued from inside a task being
+// the smaller pieces of the one it just split, and once it runs dry takes
+// the oldest task of another queue, which tends to be a big one.
+struct ThreadPool
+{
+    // receives the index of the thread running it, in [0, size())
+    using Task = std::function<void(std::size_t worker)>;
+
+    explicit ThreadPool(std::size_t threads);
+
+    // waits for the running tasks, tasks still queued are dropped
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    // queues on the calling thread's own queue from inside a task, on the
+    // queues in turn from anywhere else
+    void submit(Task task);
+
+    // blocks until every task submitted so far, and the ones they
+    // submitted, has run
+    void wait();
+
+    [[nodiscard]] std::size_t size() const noexcept { return queues.size(); }
+
+  private:
+    struct alignas(64) Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    [[nodiscard]] bool try_pop(std::size_t worker, Task& task);
+    [[nodiscard]] bool try_steal(std::size_t worker, Task& task);
+    void run(std::size_t worker);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    // tasks sitting in a queue, and tasks not finished yet
+    std::atomic<std::size_t> queued = 0;
+    std::atomic<std::size_t> pending = 0;
+    std::atomic<std::size_t> next_queue = 0;
+
+    // idle threads and wait() sleep on these
+    std::mutex sleep_mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    bool stopping = false;
+
+    // last, so the threads are joined before anything above goes away
+    std::vector<std::jthread> threads;
+};
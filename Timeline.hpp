@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "Logic.h"
+#include "Pieces.hpp"
+
+// replay of the game so far, advanced by the frame loop instead of blocking
+// it. Shows the board after the first `ply` moves, keeping that board around
+// so stepping forward is a single make_move and a seek anywhere else is a
+// GameData::position_at, a few dozen moves at most.
+struct Timeline
+{
+    bool active = false;  // replaying, the live game is hidden meanwhile
+    bool playing = false; // moving forward on its own every step_ms
+    std::size_t ply = 0;
+    BoardInfo board{};
+    uint32_t step_ms = 500;
+    uint32_t next_step = 0; // time of the next automatic step
+
+    // starts from the first position, playing
+    void open(GameData const& game, uint32_t const now)
+    {
+        active = true;
+        ply = 0;
+        board = game.position_at(0);
+        play(now);
+    }
+
+    void close()
+    {
+        active = false;
+        playing = false;
+    }
+
+    void play(uint32_t const now)
+    {
+        playing = true;
+        next_step = now + step_ms;
+    }
+
+    void toggle(uint32_t const now)
+    {
+        if (playing)
+            playing = false;
+        else
+            play(now);
+    }
+
+    void seek(GameData const& game, std::size_t const to)
+    {
+        auto const target = std::min(to, game.ply_count());
+
+        if (target == ply + 1)
+            (void)make_move(board, game.move_at(ply));
+        else if (target != ply)
+            board = game.position_at(target);
+
+        ply = target;
+    }
+
+    void step(GameData const& game, int const delta)
+    {
+        playing = false;
+        seek(game,
+             delta < 0 and std::size_t(-delta) > ply ? 0 : ply + delta);
+    }
+
+    // moves forward if it is time to, returns whether the board changed
+    bool update(GameData const& game, uint32_t const now)
+    {
+        if (not active or not playing or now < next_step)
+            return false;
+
+        if (ply >= game.ply_count()) {
+            playing = false;
+            return false;
+        }
+
+        seek(game, ply + 1);
+        next_step = now + step_ms;
+        return true;
+    }
+};
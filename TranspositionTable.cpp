@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "Profile.h"
+#include "TranspositionTable.h"
+
+namespace {
+
+// data word layout :
+//   bits  0-15 packed move, 0 when there is none (a1a1 is never a move)
+//   bits 16-31 score
+//   bits 32-39 depth
+//   bits 40-41 bound
+//   bits 42-47 generation
+//   bit  48    always set, tells a written slot from an empty one
+constexpr uint64_t used_bit = uint64_t{ 1 } << 48;
+
+constexpr uint64_t
+pack(TTEntry const& e, uint8_t const generation)
+{
+    uint64_t const mv = e.move ? pack_move(*e.move) : 0;
+    return mv | uint64_t{ static_cast<uint16_t>(e.score) } << 16 |
+           uint64_t{ static_cast<uint8_t>(e.depth) } << 32 |
+           uint64_t{ e.bound } << 40 | uint64_t{ generation } << 42 |
+           used_bit;
+}
+
+constexpr TTEntry
+unpack(uint64_t const data)
+{
+    auto const mv = static_cast<uint16_t>(data);
+    return {
+        .move = mv ? std::optional{ unpack_move(mv) } : std::nullopt,
+        .score = static_cast<int16_t>(data >> 16),
+        .depth = static_cast<int8_t>(data >> 32),
+        .bound = Bound::Bound((data >> 40) & 3),
+    };
+}
+
+constexpr uint8_t
+generation_of(uint64_t const data)
+{
+    return (data >> 42) & 63;
+}
+
+// both words of a slot are read and written one at a time, a torn pair is
+// caught by the key check
+uint64_t
+load_word(uint64_t& word) noexcept
+{
+    return std::atomic_ref{ word }.load(std::memory_order_relaxed);
+}
+
+void
+store_word(uint64_t& word, uint64_t const value) noexcept
+{
+    std::atomic_ref{ word }.store(value, std::memory_order_relaxed);
+}
+
+}
+
+TranspositionTable::TranspositionTable(std::size_t const megabytes)
+{
+    resize(megabytes);
+}
+
+void
+TranspositionTable::resize(std::size_t const megabytes)
+{
+    auto const wanted = std::max<std::size_t>(1, megabytes) << 20;
+    bucket_count = std::bit_floor(wanted / sizeof(Bucket));
+
+    buckets.reset();
+    buckets = std::make_unique_for_overwrite<Bucket[]>(bucket_count);
+
+    clear();
+}
+
+void
+TranspositionTable::clear()
+{
+    auto const threads = std::max(1u, std::thread::hardware_concurrency());
+    auto const chunk = (bucket_count + threads - 1) / threads;
+
+    std::vector<std::jthread> workers;
+    workers.reserve(threads);
+
+    for (std::size_t begin = 0; begin < bucket_count; begin += chunk) {
+        auto const end = std::min(bucket_count, begin + chunk);
+
+        workers.emplace_back([this, begin, end] {
+            std::memset(&buckets[begin], 0, (end - begin) * sizeof(Bucket));
+        });
+    }
+
+    generation = 0;
+}
+
+std::optional<TTEntry>
+TranspositionTable::probe(uint64_t const key) const noexcept
+{
+    PROFILE_ZONE("tt probe");
+
+    for (auto& slot : bucket(key).slots) {
+        auto const data = load_word(slot.data);
+        auto const check = load_word(slot.check);
+
+        if ((check ^ data) == key and data != 0) {
+            PROFILE_COUNT("tt hits", 1);
+            return unpack(data);
+        }
+    }
+
+    PROFILE_COUNT("tt misses", 1);
+    return {};
+}
+
+void
+TranspositionTable::store(uint64_t const key, TTEntry const& entry) noexcept
+{
+    PROFILE_ZONE("tt store");
+
+    auto& slots = bucket(key).slots;
+
+    // same position first, otherwise the least valuable slot: stale ones
+    // from older searches, then the shallowest
+    Slot* target = &slots[0];
+    int target_value = std::numeric_limits<int>::max();
+    uint64_t previous = 0;
+
+    for (auto& slot : slots) {
+        auto const data = load_word(slot.data);
+        auto const check = load_word(slot.check);
+
+        if ((check ^ data) == key or data == 0) {
+            target = &slot;
+            previous = data;
+            break;
+        }
+
+        auto const age = (generation - generation_of(data)) & 63;
+        auto const value = static_cast<int8_t>(data >> 32) - 8 * age;
+
+        if (value < target_value) {
+            target_value = value;
+            target = &slot;
+        }
+    }
+
+    auto stored = entry;
+
+    if (previous != 0) {
+        auto const old = unpack(previous);
+
+        // a deeper result for the same position from this search is worth
+        // more than a shallow bound, unless the new one is exact
+        if (entry.bound != Bound::exact and entry.depth < old.depth - 2 and
+            generation_of(previous) == generation)
+            return;
+
+        // keep the best move from before if this result has none
+        if (not stored.move)
+            stored.move = old.move;
+    }
+
+    auto const data = pack(stored, generation);
+    store_word(target->check, key ^ data);
+    store_word(target->data, data);
+}
+
+int
+TranspositionTable::hashfull() const noexcept
+{
+    int used = 0;
+    auto const sampled = std::min<std::size_t>(250, bucket_count);
+
+    for (std::size_t i = 0; i < sampled; ++i) {
+        for (auto& slot : buckets[i].slots) {
+            auto const data = load_word(slot.data);
+            if (data != 0 and generation_of(data) == generation)
+                ++used;
+        }
+    }
+
+    return static_cast<int>(used * 1000 / (sampled * 4));
+}
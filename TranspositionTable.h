@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "Pieces.hpp"
+
+namespace Bound {
+enum Bound : uint8_t
+{
+    none,
+    upper, // failed low, the score is at most this
+    lower, // failed high, the score is at least this
+    exact,
+};
+};
+
+struct TTEntry
+{
+    std::optional<Move> move;
+    int16_t score;
+    int8_t depth;
+    Bound::Bound bound;
+};
+
+// hash table of search results shared by every search thread without locks.
+// Each slot is two 64-bit words, the packed data and the key xored with it,
+// so a slot torn by two threads writing at once simply fails the key check
+// on the next probe instead of handing out a mix of both writes.
+struct TranspositionTable
+{
+    // plain words accessed through std::atomic_ref, which keeps the table
+    // trivially constructible so clear() can fault its pages in from every
+    // thread instead of the allocating one
+    struct Slot
+    {
+        uint64_t check; // key ^ data
+        uint64_t data;  // 0 while empty
+    };
+
+    // one cache line per bucket, a probe touches a single line
+    struct alignas(64) Bucket
+    {
+        std::array<Slot, 4> slots;
+    };
+
+    explicit TranspositionTable(std::size_t megabytes = 16);
+
+    // drops every entry, the size is rounded down to a power of two buckets
+    void resize(std::size_t megabytes);
+
+    // zeroes the table, split over every core
+    void clear();
+
+    // to be called before each search so old entries get replaced first
+    void new_search() { generation = (generation + 1) & 63; }
+
+    [[nodiscard]] std::optional<TTEntry> probe(uint64_t key) const noexcept;
+
+    void store(uint64_t key, TTEntry const& entry) noexcept;
+
+    // permille of sampled slots written during the current search
+    [[nodiscard]] int hashfull() const noexcept;
+
+    [[nodiscard]] std::size_t size_mb() const noexcept
+    {
+        return (bucket_count * sizeof(Bucket)) >> 20;
+    }
+
+  private:
+    [[nodiscard]] Bucket& bucket(uint64_t const key) const noexcept
+    {
+        return buckets[key & (bucket_count - 1)];
+    }
+
+    std::unique_ptr<Bucket[]> buckets;
+    std::size_t bucket_count = 0;
+    uint8_t generation = 0;
+};
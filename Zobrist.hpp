@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// random keys xored together into BoardInfo::hash, generated at compile time
+// so every build and every run agree on the hash of a position
+namespace Zobrist {
+
+struct Keys
+{
+    // indexed by BoardInfo::mailbox value then square
+    std::array<std::array<uint64_t, 64>, 12> pieces;
+    uint64_t black_to_move;
+    // indexed by the Castling bits, no rights hashes to 0
+    std::array<uint64_t, 16> castling;
+    // indexed by the file of the en passant square
+    std::array<uint64_t, 8> en_passant;
+};
+
+// splitmix64, good enough to spread keys and trivially constexpr
+constexpr uint64_t
+next(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr Keys keys = [] {
+    Keys k{};
+    uint64_t state = 0x5EED;
+
+    for (auto& squares : k.pieces)
+        for (auto& key : squares)
+            key = next(state);
+
+    k.black_to_move = next(state);
+
+    for (auto& key : k.castling)
+        key = next(state);
+    k.castling[0] = 0;
+
+    for (auto& key : k.en_passant)
+        key = next(state);
+
+    return k;
+}();
+
+};
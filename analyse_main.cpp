@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Fen.h"
+#include "Logic.h"
+#include "Notation.h"
+#include "Profile.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+namespace {
+
+void
+print_usage(char const* name)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--depth N] [--nodes N] [--time ms] [--hash MB] "
+                 "[--threads N] [--bench] [--profile trace.json] "
+                 "[--fen FEN] [moves...]\n",
+                 name);
+}
+
+// middlegame-ish positions reached from the start, for --bench
+constexpr auto bench_positions = std::to_array<std::string_view>({
+  "",
+  "e2e4 e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6 d2d3 b7b5",
+  "d2d4 g8f6 c2c4 e7e6 b1c3 f8b4 d1c2 d7d5 a2a3 b4c3 c2c3",
+  "e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3 a7a6 c1e3 e7e5",
+  "d2d4 d7d5 c2c4 e7e6 b1c3 g8f6 c1g5 f8e7 e2e3 b8d7 g1f3 h7h6",
+  "e2e4 e7e6 d2d4 d7d5 b1c3 f8b4 e4e5 c7c5 a2a3 b4c3 b2c3 g8e7",
+});
+
+// time to reach the same depth on every bench position with 1, 2, 4, ...
+// threads, each run starting from an empty table
+int
+bench(SearchLimits limits, std::size_t const hash_mb, int const max_threads)
+{
+    std::printf("%8s %12s %14s %12s %8s\n",
+                "threads",
+                "time (ms)",
+                "nodes",
+                "nps",
+                "speedup");
+
+    double single_thread_ms = 0;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        limits.threads = threads;
+
+        uint64_t nodes = 0;
+        auto const start = std::chrono::steady_clock::now();
+
+        for (auto const line : bench_positions) {
+            auto const game_data = play_moves(line);
+            if (not game_data) {
+                std::fprintf(stderr,
+                             "bad bench line : %.*s\n",
+                             int(line.size()),
+                             line.data());
+                return EXIT_FAILURE;
+            }
+
+            TranspositionTable tt{ hash_mb };
+            nodes += search(game_data->current_board, limits, tt).nodes;
+        }
+
+        std::chrono::duration<double, std::milli> const elapsed =
+          std::chrono::steady_clock::now() - start;
+        auto const ms = elapsed.count();
+
+        if (threads == 1)
+            single_thread_ms = ms;
+
+        std::printf("%8d %12.0f %14llu %12.0f %7.2fx\n",
+                    threads,
+                    ms,
+                    static_cast<unsigned long long>(nodes),
+                    nodes * 1000.0 / std::max(ms, 1.0),
+                    single_thread_ms / std::max(ms, 1.0));
+        std::fflush(stdout);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+}
+
+// usage: analyse [--depth N] [--nodes N] [--time ms] [--hash MB]
+//                [--threads N] [--bench] [--profile trace.json]
+//                [--fen FEN] [moves...]
+// searches the starting position, or --fen, after the given moves and prints
+// every completed iteration, then the best move.
+// --bench instead reports the time to depth (default 10) over a fixed set of
+// positions for 1, 2, 4, ... threads, up to --threads (default every core).
+// --profile writes where the time went as a Chrome trace, in builds
+// configured with -DCHESS_PROFILE=ON.
+int
+main(int const argc, char const* const* const argv)
+{
+    SearchLimits limits{};
+    std::size_t hash_mb = 64;
+    int threads = 0;
+    bool bench_mode = false;
+    bool depth_given = false;
+    char const* profile_path = nullptr;
+    std::string_view fen;
+    std::vector<std::string_view> played;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{ argv[i] };
+
+        if (arg == "--bench") {
+            bench_mode = true;
+        } else if (arg.starts_with("--")) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            std::string_view const value{ argv[++i] };
+            int64_t ms{};
+            bool ok;
+
+            if (arg == "--depth")
+                ok = depth_given = parse_number(value, limits.depth);
+            else if (arg == "--threads")
+                ok = parse_number(value, threads) and threads > 0;
+            else if (arg == "--nodes")
+                ok = parse_number(value, limits.nodes);
+            else if (arg == "--hash")
+                ok = parse_number(value, hash_mb);
+            else if (arg == "--profile")
+                ok = (profile_path = argv[i]);
+            else if (arg == "--fen")
+                ok = not(fen = value).empty();
+            else if (arg == "--time") {
+                ok = parse_number(value, ms);
+                limits.time = std::chrono::milliseconds{ ms };
+            } else
+                ok = false;
+
+            if (not ok) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else {
+            played.push_back(arg);
+        }
+    }
+
+    if (bench_mode) {
+        if (not depth_given)
+            limits.depth = 10;
+        if (threads == 0)
+            threads = static_cast<int>(
+              std::max(1u, std::thread::hardware_concurrency()));
+        auto const status = bench(limits, hash_mb, threads);
+        if (profile_path and not Profile::report(profile_path))
+            return EXIT_FAILURE;
+        return status;
+    }
+
+    limits.threads = std::max(1, threads);
+
+    GameData game_data{ .current_board{ generate_default_game_data() },
+                        .history{} };
+    std::vector<uint64_t> positions;
+
+    if (not fen.empty()) {
+        auto const position = parse_fen(fen);
+        if (not position) {
+            std::fprintf(
+              stderr, "bad fen : %.*s\n", int(fen.size()), fen.data());
+            return EXIT_FAILURE;
+        }
+        game_data.current_board = position->board;
+    }
+
+    for (auto const str : played) {
+        auto const mv = parse_move(game_data.current_board, str);
+        if (not mv) {
+            std::fprintf(
+              stderr, "illegal move : %.*s\n", int(str.size()), str.data());
+            return EXIT_FAILURE;
+        }
+        positions.push_back(game_data.current_board.hash);
+        game_data.play(*mv);
+    }
+
+    TranspositionTable tt{ hash_mb };
+
+    auto const result = search(
+      game_data.current_board,
+      limits,
+      tt,
+      [](SearchInfo const& info) {
+          std::string pv;
+          for (auto const mv : info.pv)
+              pv += " " + to_string(mv);
+
+          std::printf("depth %d score %s nodes %llu nps %llu time %lld pv%s\n",
+                      info.depth,
+                      format_score(info.score).c_str(),
+                      static_cast<unsigned long long>(info.nodes),
+                      static_cast<unsigned long long>(info.nps),
+                      static_cast<long long>(info.elapsed.count()),
+                      pv.c_str());
+          std::fflush(stdout);
+      },
+      positions);
+
+    if (result.pv.empty())
+        std::puts("bestmove (none)");
+    else
+        std::printf("bestmove %s\n", to_string(result.pv.front()).c_str());
+
+    if (profile_path and not Profile::report(profile_path))
+        return EXIT_FAILURE;
+}
@@ -0,0 +1,461 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) or defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+#include "Logic.h"
+#include "Notation.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// the time stamp counter where there is one. It ticks at a fixed reference
+// rate rather than the core clock, close enough to compare two builds on the
+// same machine
+#if defined(__x86_64__) or defined(__i386__) or defined(_M_X64) or            \
+  defined(_M_IX86)
+constexpr bool has_cycles = true;
+
+uint64_t
+cycles() noexcept
+{
+    return __rdtsc();
+}
+#else
+constexpr bool has_cycles = false;
+
+uint64_t
+cycles() noexcept
+{
+    return 0;
+}
+#endif
+
+// makes the compiler believe value is used, so the work producing it can't
+// be thrown away
+template<typename T>
+void
+keep(T const& value) noexcept
+{
+#if defined(__GNUC__) or defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static void const* volatile sink;
+    sink = &value;
+#endif
+}
+
+// the positions every benchmark walks, from the start and from the
+// middlegames analyse --bench uses
+constexpr auto lines = std::to_array<std::string_view>({
+  "",
+  "e2e4 e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6 d2d3 b7b5",
+  "d2d4 g8f6 c2c4 e7e6 b1c3 f8b4 d1c2 d7d5 a2a3 b4c3 c2c3",
+  "e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3 a7a6 c1e3 e7e5",
+  "d2d4 d7d5 c2c4 e7e6 b1c3 g8f6 c1g5 f8e7 e2e3 b8d7 g1f3 h7h6",
+  "e2e4 e7e6 d2d4 d7d5 b1c3 f8b4 e4e5 c7c5 a2a3 b4c3 b2c3 g8e7",
+  "e2e4 d7d5 e4d5 d8d5 b1c3 d5a5 d2d4 g8f6 g1f3 c8f5 f1c4 e7e6 e1g1 c7c6",
+  "g1f3 d7d5 g2g3 g8f6 f1g2 e7e6 e1g1 f8e7 d2d3 e8g8 b1d2 c7c5 e2e4 b8c6",
+});
+
+struct Options
+{
+    int warmup = 3;
+    int samples = 31;
+    // a sample repeats the operation until it took at least this long
+    Clock::duration min_sample = std::chrono::milliseconds{ 2 };
+    std::string_view filter;
+};
+
+struct Stats
+{
+    double median, p10, p90, min, max, mean;
+};
+
+struct Result
+{
+    std::string name;
+    std::size_t items;       // calls of the thing measured in one operation
+    uint64_t iterations = 0; // operations per sample
+    Stats ns;                // per item
+    std::optional<Stats> cycles;
+};
+
+// linear interpolation between the closest ranks, values sorted
+double
+percentile(std::vector<double> const& values, double const p)
+{
+    auto const rank = p * (values.size() - 1);
+    auto const below = static_cast<std::size_t>(rank);
+    auto const above = std::min(below + 1, values.size() - 1);
+    return values[below] + (values[above] - values[below]) * (rank - below);
+}
+
+Stats
+summarise(std::vector<double> values)
+{
+    std::ranges::sort(values);
+
+    double sum = 0;
+    for (auto const v : values)
+        sum += v;
+
+    return { .median = percentile(values, 0.5),
+             .p10 = percentile(values, 0.1),
+             .p90 = percentile(values, 0.9),
+             .min = values.front(),
+             .max = values.back(),
+             .mean = sum / values.size() };
+}
+
+// runs op (items calls of what is being measured) until the timings settle:
+// the repeat count is doubled until one sample lasts min_sample, a few
+// samples are thrown away to warm caches and predictors, then every sample
+// is kept
+template<typename Op>
+std::optional<Result>
+measure(Options const& options,
+        std::string name,
+        std::size_t const items,
+        Op&& op)
+{
+    if (name.find(options.filter) == name.npos)
+        return {};
+
+    auto const batch = [&op](uint64_t const n) {
+        for (uint64_t i = 0; i < n; ++i)
+            op();
+    };
+
+    Result result{ .name = std::move(name), .items = items };
+
+    result.iterations = 1;
+    while (true) {
+        auto const start = Clock::now();
+        batch(result.iterations);
+        if (Clock::now() - start >= options.min_sample)
+            break;
+        result.iterations *= 2;
+    }
+
+    for (int i = 0; i < options.warmup; ++i)
+        batch(result.iterations);
+
+    std::vector<double> ns;
+    std::vector<double> ticks;
+    auto const per_item = double(result.iterations) * items;
+
+    for (int i = 0; i < options.samples; ++i) {
+        auto const start = Clock::now();
+        auto const start_cycles = cycles();
+        batch(result.iterations);
+        auto const end_cycles = cycles();
+        std::chrono::duration<double, std::nano> const elapsed =
+          Clock::now() - start;
+
+        ns.push_back(elapsed.count() / per_item);
+        ticks.push_back((end_cycles - start_cycles) / per_item);
+    }
+
+    result.ns = summarise(ns);
+    if (has_cycles)
+        result.cycles = summarise(ticks);
+
+    std::fprintf(stderr,
+                 "%-28s %10.1f %10.1f %10.1f %10.1f\n",
+                 result.name.c_str(),
+                 result.ns.median,
+                 result.ns.p10,
+                 result.ns.p90,
+                 result.cycles ? result.cycles->median : 0.0);
+
+    return result;
+}
+
+// every piece of each type belonging to the player to move, and the board
+// it stands on
+struct Placed
+{
+    BoardInfo const* board;
+    Piece piece;
+};
+
+std::vector<Result>
+run_all(std::vector<BoardInfo> const& boards, Options const& options)
+{
+    std::vector<Result> results;
+    auto const add = [&results](std::optional<Result> r) {
+        if (r)
+            results.push_back(std::move(*r));
+    };
+
+    for (int type = 0; type < PieceType::Count; ++type) {
+        std::vector<Placed> placed;
+        for (auto const& board : boards)
+            for (auto bb = board.pieces[board.turn][type]; bb;)
+                placed.push_back(
+                  { &board, *board.peek(to_position(pop_lsb(bb))) });
+
+        add(measure(options,
+                    std::string{ "get_moves/" } + PieceType::names[type],
+                    placed.size(),
+                    [&placed] {
+                        for (auto const& [board, piece] : placed) {
+                            MoveList moves;
+                            get_moves(piece, *board, moves);
+                            keep(moves.count);
+                        }
+                    }));
+    }
+
+    add(measure(options, "get_all_moves", boards.size(), [&boards] {
+        for (auto const& board : boards) {
+            MoveList moves;
+            get_all_moves(board, moves);
+            keep(moves.count);
+        }
+    }));
+
+    add(measure(options, "BoardInfo::peek", boards.size() * 64, [&boards] {
+        for (auto const& board : boards)
+            for (int8_t y = 0; y < 8; ++y)
+                for (int8_t x = 0; x < 8; ++x)
+                    keep(board.peek(x, y));
+    }));
+
+    add(measure(options, "BoardInfo::get", boards.size() * 64, [&boards] {
+        for (auto const& board : boards)
+            for (int8_t y = 0; y < 8; ++y)
+                for (int8_t x = 0; x < 8; ++x)
+                    keep(board.get(x, y));
+    }));
+
+    // every piece of the player to move onto the first empty square and
+    // back, on a copy so the positions stay as they were
+    std::vector<BoardInfo> scratch = boards;
+    std::vector<std::pair<BoardInfo::PeekResult, Position>> moved;
+    std::vector<std::pair<BoardInfo*, Piece>> taken;
+    for (auto& board : scratch) {
+        auto const empty = to_position(lsb(~board.occupied()));
+        for (auto bb = board.occupancy[board.turn]; bb;) {
+            auto const pos = to_position(pop_lsb(bb));
+            moved.push_back({ board.get(pos), empty });
+        }
+        for (auto bb = board.occupancy[not board.turn]; bb;)
+            taken.push_back(
+              { &board, *board.peek(to_position(pop_lsb(bb))) });
+    }
+
+    add(measure(options, "BoardInfo::move", moved.size() * 2, [&] {
+        std::size_t i = 0;
+        for (auto& board : scratch) {
+            for (auto const end = i + popcount(board.occupancy[board.turn]);
+                 i < end;
+                 ++i) {
+                auto const& [from, to] = moved[i];
+                board.move(from, to);
+                board.move({ to_square(to), from.piece }, from.piece.pos);
+            }
+        }
+        keep(scratch);
+    }));
+
+    // put back after each take
+    add(measure(options, "BoardInfo::take", taken.size(), [&taken] {
+        for (auto const& [board, piece] : taken) {
+            board->take(piece.pos);
+            board->put(piece);
+        }
+        keep(taken);
+    }));
+
+    std::vector<std::pair<BoardInfo*, Move>> played;
+    for (auto& board : scratch) {
+        MoveList moves;
+        get_all_moves(board, moves);
+        for (auto const mv : moves)
+            played.push_back({ &board, mv });
+    }
+
+    add(measure(options, "make_move+unmake_move", played.size(), [&played] {
+        for (auto const& [board, mv] : played) {
+            auto const undo = make_move(*board, mv);
+            unmake_move(*board, mv, undo);
+        }
+        keep(played);
+    }));
+
+    add(measure(options, "generate_default_game_data", 1, [] {
+        keep(generate_default_game_data());
+    }));
+
+    return results;
+}
+
+void
+write_stats(std::FILE* const out, Stats const& s)
+{
+    std::fprintf(out,
+                 "{\"median\": %.3f, \"p10\": %.3f, \"p90\": %.3f, "
+                 "\"min\": %.3f, \"max\": %.3f, \"mean\": %.3f}",
+                 s.median,
+                 s.p10,
+                 s.p90,
+                 s.min,
+                 s.max,
+                 s.mean);
+}
+
+// one benchmark a line, so two runs can be compared with a plain diff
+void
+write_json(std::FILE* const out,
+           std::vector<Result> const& results,
+           Options const& options)
+{
+    std::fprintf(out, "{\n  \"context\": {");
+#if defined(__clang__)
+    std::fprintf(out, "\"compiler\": \"clang %s\", ", __clang_version__);
+#elif defined(__GNUC__)
+    std::fprintf(out, "\"compiler\": \"gcc %s\", ", __VERSION__);
+#endif
+#ifdef NDEBUG
+    std::fprintf(out, "\"assertions\": false, ");
+#else
+    std::fprintf(out, "\"assertions\": true, ");
+#endif
+    std::fprintf(out,
+                 "\"positions\": %zu, \"samples\": %d, \"warmup\": %d, "
+                 "\"cycles\": \"%s\"},\n  \"benchmarks\": [",
+                 lines.size(),
+                 options.samples,
+                 options.warmup,
+                 has_cycles ? "tsc" : "none");
+
+    char const* separator = "\n";
+    for (auto const& r : results) {
+        std::fprintf(out,
+                     "%s    {\"name\": \"%s\", \"items\": %zu, "
+                     "\"iterations\": %llu, \"ns_per_item\": ",
+                     separator,
+                     r.name.c_str(),
+                     r.items,
+                     static_cast<unsigned long long>(r.iterations));
+        write_stats(out, r.ns);
+        std::fprintf(out, ", \"cycles_per_item\": ");
+        if (r.cycles)
+            write_stats(out, *r.cycles);
+        else
+            std::fprintf(out, "null");
+        std::fprintf(out, "}");
+        separator = ",\n";
+    }
+
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+void
+print_usage(char const* name)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--samples N] [--warmup N] [--min-time ms] "
+                 "[--filter text] [--json file]\n",
+                 name);
+}
+
+}
+
+// usage: chess_bench [--samples N] [--warmup N] [--min-time ms]
+//                    [--filter text] [--json file]
+// times the core primitives over a fixed set of positions and prints the
+// median, 10th and 90th percentile nanoseconds and median cycles per call to
+// stderr. --json writes every statistic to file ("-" for stdout) to keep and
+// diff against another build, --filter only runs the benchmarks whose name
+// contains text.
+int
+main(int const argc, char const* const* const argv)
+{
+    Options options{};
+    char const* json_path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{ argv[i] };
+        bool ok = i + 1 < argc;
+
+        if (ok) {
+            std::string_view const value{ argv[++i] };
+            int ms = 0;
+
+            if (arg == "--samples")
+                ok = parse_number(value, options.samples) and
+                     options.samples > 0;
+            else if (arg == "--warmup")
+                ok = parse_number(value, options.warmup);
+            else if (arg == "--min-time") {
+                ok = parse_number(value, ms) and ms > 0;
+                options.min_sample = std::chrono::milliseconds{ ms };
+            } else if (arg == "--filter")
+                options.filter = value;
+            else if (arg == "--json")
+                json_path = argv[i];
+            else
+                ok = false;
+        }
+
+        if (not ok) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<BoardInfo> boards;
+    for (auto const line : lines) {
+        auto const game_data = play_moves(line);
+        if (not game_data) {
+            std::fprintf(
+              stderr, "bad line : %.*s\n", int(line.size()), line.data());
+            return EXIT_FAILURE;
+        }
+        boards.push_back(game_data->current_board);
+    }
+
+    std::fprintf(stderr,
+                 "%-28s %10s %10s %10s %10s\n",
+                 "benchmark",
+                 "ns median",
+                 "ns p10",
+                 "ns p90",
+                 "cycles");
+
+    auto const results = run_all(boards, options);
+
+    if (not json_path)
+        return EXIT_SUCCESS;
+
+    if (std::string_view{ json_path } == "-") {
+        write_json(stdout, results, options);
+        return EXIT_SUCCESS;
+    }
+
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> const file{
+        std::fopen(json_path, "w"), &std::fclose
+    };
+    if (not file) {
+        std::fprintf(stderr, "can't write %s\n", json_path);
+        return EXIT_FAILURE;
+    }
+    write_json(file.get(), results, options);
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Fen.h"
+#include "Logic.h"
+#include "MappedFile.h"
+#include "Notation.h"
+#include "PositionIndex.h"
+#include "ThreadPool.h"
+
+namespace {
+
+void
+print_usage(char const* name)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--threads N] [--max-ply N] [--memory MB] "
+                 "--build <index> <file.pgn>...\n"
+                 "       %s [--fen FEN] <index> [moves...]\n",
+                 name,
+                 name);
+}
+
+int
+build(char const* const index_path,
+      std::vector<char const*> const& pgn_paths,
+      std::size_t const threads,
+      std::size_t const max_plies,
+      std::size_t const memory_mb)
+{
+    std::vector<MappedFile> files;
+    std::vector<std::string_view> texts;
+    uint64_t bytes = 0;
+    for (auto const* const path : pgn_paths) {
+        auto file = MappedFile::open(path);
+        if (not file) {
+            std::fprintf(stderr, "can't read %s\n", path);
+            return EXIT_FAILURE;
+        }
+        bytes += file->size();
+        texts.push_back(file->text());
+        files.push_back(std::move(*file));
+    }
+
+    ThreadPool pool{ threads };
+    auto const start = std::chrono::steady_clock::now();
+    auto const stats =
+      build_position_index(texts, index_path, pool, max_plies, memory_mb);
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    auto const seconds = std::max(elapsed.count(), 1e-9);
+
+    if (not stats) {
+        std::fprintf(stderr, "can't write %s\n", index_path);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%llu games (%llu skipped), %llu positions indexed, "
+                "%llu entries\n",
+                static_cast<unsigned long long>(stats->pgn.games),
+                static_cast<unsigned long long>(stats->pgn.errors),
+                static_cast<unsigned long long>(stats->positions),
+                static_cast<unsigned long long>(stats->entries));
+    std::printf("%.3f s, %.0f games/second, %.1f MB/second of PGN\n",
+                seconds,
+                stats->pgn.games / seconds,
+                bytes / seconds / (1 << 20));
+    return EXIT_SUCCESS;
+}
+
+int
+query(char const* const index_path,
+      std::string_view const fen,
+      std::vector<std::string_view> const& played)
+{
+    auto board = generate_default_game_data();
+    if (not fen.empty()) {
+        auto const position = parse_fen(fen);
+        if (not position) {
+            std::fprintf(
+              stderr, "bad fen : %.*s\n", int(fen.size()), fen.data());
+            return EXIT_FAILURE;
+        }
+        board = position->board;
+    }
+    for (auto const str : played) {
+        auto const mv = parse_move(board, str);
+        if (not mv) {
+            std::fprintf(
+              stderr, "illegal move : %.*s\n", int(str.size()), str.data());
+            return EXIT_FAILURE;
+        }
+        (void)make_move(board, *mv);
+    }
+
+    auto const open_start = std::chrono::steady_clock::now();
+    auto const index = PositionIndex::open(index_path);
+    if (not index) {
+        std::fprintf(stderr, "%s isn't a position index\n", index_path);
+        return EXIT_FAILURE;
+    }
+
+    // the first lookup pays for the pages it touches, that is the cost
+    // that matters
+    auto const find_start = std::chrono::steady_clock::now();
+    auto const found = index->find(board.hash);
+    auto const find_end = std::chrono::steady_clock::now();
+
+    std::vector<IndexEntry> moves(found.begin(), found.end());
+    std::ranges::sort(moves, [](IndexEntry const& a, IndexEntry const& b) {
+        return a.games() > b.games();
+    });
+
+    uint64_t games = 0;
+    for (auto const& entry : moves)
+        games += entry.games();
+
+    std::printf("%llu games\n", static_cast<unsigned long long>(games));
+    if (not moves.empty())
+        std::printf("%-8s %10s %7s %7s %7s\n",
+                    "move",
+                    "games",
+                    "white",
+                    "draw",
+                    "black");
+    for (auto const& entry : moves) {
+        auto const share = [&](GameResult::GameResult const result) {
+            return 100.0 * entry.results[result] / entry.games();
+        };
+        std::printf("%-8s %10llu %6.1f%% %6.1f%% %6.1f%%\n",
+                    to_san(board, unpack_move(entry.move)).c_str(),
+                    static_cast<unsigned long long>(entry.games()),
+                    share(GameResult::white_wins),
+                    share(GameResult::draw),
+                    share(GameResult::black_wins));
+    }
+
+    std::chrono::duration<double, std::micro> const open_us =
+      find_start - open_start;
+    std::chrono::duration<double, std::micro> const find_us =
+      find_end - find_start;
+    std::printf("%llu entries, opened in %.1f us, found in %.1f us\n",
+                static_cast<unsigned long long>(index->entries.size()),
+                open_us.count(),
+                find_us.count());
+    return EXIT_SUCCESS;
+}
+
+}
+
+// usage: book [--threads N] [--max-ply N] [--memory MB] --build <index>
+//             <file.pgn>...
+//        book [--fen FEN] <index> [moves...]
+// --build reads the games of the PGN files over --threads threads (default
+// every core) and writes the index of their first --max-ply plies (default
+// all of them): for every position, what was played and how it ended. Each
+// ply takes 16 bytes until it is written, past --memory MB (default 1024)
+// they are spilled to sorted runs next to the index and merged at the end,
+// so a big collection needs about twice the index in free disk.
+// Otherwise looks up the starting position, or --fen, after the given moves
+// and prints the moves played from it, most played first.
+int
+main(int const argc, char const* const* const argv)
+{
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t max_plies = std::size_t(-1);
+    std::size_t memory_mb = 1024;
+    char const* build_path = nullptr;
+    std::string_view fen;
+    std::vector<char const*> rest;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{ argv[i] };
+        bool ok = true;
+
+        if (arg.starts_with("--") and i + 1 < argc) {
+            std::string_view const value{ argv[++i] };
+            if (arg == "--threads")
+                ok = parse_number(value, threads) and threads > 0;
+            else if (arg == "--max-ply")
+                ok = parse_number(value, max_plies);
+            else if (arg == "--memory")
+                ok = parse_number(value, memory_mb) and memory_mb > 0;
+            else if (arg == "--build")
+                build_path = argv[i];
+            else if (arg == "--fen")
+                fen = value;
+            else
+                ok = false;
+        } else if (not arg.starts_with("--")) {
+            rest.push_back(argv[i]);
+        } else {
+            ok = false;
+        }
+
+        if (not ok) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (build_path) {
+        if (rest.empty()) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        return build(build_path, rest, threads, max_plies, memory_mb);
+    }
+
+    if (rest.empty()) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string_view> const played(rest.begin() + 1, rest.end());
+    return query(rest.front(), fen, played);
+}
@@ -0,0 +1,99 @@
+#define SDL_MAIN_HANDLED
+#include "SDL.h"
+#include "SDL_image.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace {
+
+// no logging deleter from CustomDeleters.hpp, this runs during the build
+using Surface = std::unique_ptr<SDL_Surface, decltype(&SDL_FreeSurface)>;
+
+}
+
+// usage: embed_assets <output.cpp> <image>...
+// build step of the game: decodes every image once into RGBA and writes
+// them as arrays, so the game starts without reading or decoding anything.
+// Each image is named after its file, eg.: assets/cursor.png is "cursor".
+int
+main(int const argc, char const* const* const argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <output.cpp> <image>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // written to a temporary first so a failed run never leaves a half
+    // written source behind for the next build to pick up
+    std::filesystem::path const output{ argv[1] };
+    auto const temporary = std::filesystem::path{ output } += ".tmp";
+
+    std::ofstream out{ temporary };
+    if (not out) {
+        std::fprintf(stderr, "can't write %s\n", temporary.c_str());
+        return EXIT_FAILURE;
+    }
+
+    out << "// generated by embed_assets, do not edit\n"
+           "#include \"EmbeddedAssets.h\"\n\n"
+           "namespace {\n\n";
+
+    std::string table;
+
+    for (int i = 2; i < argc; ++i) {
+        Surface const loaded{ IMG_Load(argv[i]), &SDL_FreeSurface };
+        if (not loaded) {
+            std::fprintf(stderr, "%s : %s\n", argv[i], IMG_GetError());
+            return EXIT_FAILURE;
+        }
+
+        // whatever the file held, the game gets 4 bytes a pixel in
+        // r, g, b, a order
+        Surface const rgba{
+            SDL_ConvertSurfaceFormat(loaded.get(), SDL_PIXELFORMAT_RGBA32, 0),
+            &SDL_FreeSurface
+        };
+        if (not rgba) {
+            std::fprintf(stderr, "%s : %s\n", argv[i], SDL_GetError());
+            return EXIT_FAILURE;
+        }
+
+        auto const name = std::filesystem::path{ argv[i] }.stem().string();
+        auto const w = rgba->w;
+        auto const h = rgba->h;
+
+        SDL_LockSurface(rgba.get());
+        auto const* const pixels = static_cast<Uint8 const*>(rgba->pixels);
+
+        out << "constexpr unsigned char image" << i << "[] = {";
+        for (int y = 0; y < h; ++y) {
+            auto const* const row = pixels + y * rgba->pitch;
+            for (int x = 0; x < w * 4; ++x)
+                out << ((x % 16) ? " " : "\n  ") << int(row[x]) << ',';
+        }
+        out << "\n};\n\n";
+
+        SDL_UnlockSurface(rgba.get());
+
+        table += "    { \"" + name + "\", " + std::to_string(w) + ", " +
+                 std::to_string(h) + ", image" + std::to_string(i) + " },\n";
+    }
+
+    out << "constexpr EmbeddedImage images[] = {\n"
+        << table << "};\n\n"
+        << "}\n\n"
+           "std::span<EmbeddedImage const> const embedded_images{ images };\n";
+
+    out.close();
+    if (not out) {
+        std::fprintf(stderr, "can't write %s\n", temporary.c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::filesystem::rename(temporary, output);
+}
@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Fen.h"
+#include "Logic.h"
+#include "Notation.h"
+#include "Perft.h"
+#include "Search.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+namespace {
+
+// lines handed to a task at once, enough to make queueing them negligible
+constexpr std::size_t batch_size = 256;
+
+std::string_view
+trim(std::string_view str)
+{
+    auto const begin = str.find_first_not_of(" \t\r");
+    if (begin == str.npos)
+        return {};
+    auto const end = str.find_last_not_of(" \t\r");
+    return str.substr(begin, end - begin + 1);
+}
+
+// next space separated word, empty once there are none left
+std::string_view
+next_word(std::string_view& str)
+{
+    str = trim(str);
+    auto const end = std::min(str.find(' '), str.size());
+    auto const word = str.substr(0, end);
+    str.remove_prefix(end);
+    return word;
+}
+
+struct Settings
+{
+    bool parse_only = false;
+    int max_perft_depth = 64;
+    SearchLimits limits{};
+    std::size_t hash_mb = 16;
+};
+
+struct Totals
+{
+    std::atomic<uint64_t> positions = 0;
+    std::atomic<uint64_t> malformed = 0;
+    std::atomic<uint64_t> perft_passed = 0;
+    std::atomic<uint64_t> perft_failed = 0;
+    std::atomic<uint64_t> perft_nodes = 0;
+    std::atomic<uint64_t> moves_passed = 0;
+    std::atomic<uint64_t> moves_failed = 0;
+};
+
+struct Batch
+{
+    std::size_t first_line; // 1 based
+    std::vector<std::string> lines;
+};
+
+struct Runner
+{
+    Settings const& settings;
+    Totals totals;
+    // one table per pool thread, a search only ever touches its own
+    std::vector<std::unique_ptr<TranspositionTable>> tables;
+    std::mutex output_mutex;
+
+    void report(std::size_t const line_number,
+                std::string_view const id,
+                char const* const format,
+                auto... args)
+    {
+        std::lock_guard lock{ output_mutex };
+        std::printf("line %zu", line_number);
+        if (not id.empty())
+            std::printf(" (%.*s)", int(id.size()), id.data());
+        std::printf(" : ");
+        std::printf(format, args...);
+        std::putchar('\n');
+    }
+
+    void run(std::string_view line,
+             std::size_t const line_number,
+             std::size_t const worker)
+    {
+        line = trim(line);
+        if (line.empty() or line.front() == '#')
+            return;
+
+        // the four position fields, then the clocks if this is a FEN
+        // rather than an EPD line
+        auto rest = line;
+        for (int i = 0; i < 4; ++i)
+            next_word(rest);
+        for (int i = 0; i < 2; ++i) {
+            auto peek = rest;
+            int clock = 0;
+            if (not parse_number(next_word(peek), clock))
+                break;
+            rest = peek;
+        }
+
+        std::string_view const fen{ line.data(),
+                                    std::size_t(rest.data() - line.data()) };
+        auto const position = parse_fen(fen);
+        if (not position) {
+            totals.malformed.fetch_add(1, std::memory_order_relaxed);
+            report(line_number,
+                   {},
+                   "bad position %.*s",
+                   int(fen.size()),
+                   fen.data());
+            return;
+        }
+        totals.positions.fetch_add(1, std::memory_order_relaxed);
+
+        // operations: "opcode operand...;", perft suites write the
+        // expected counts as "D<depth> <nodes>"
+        std::string_view id;
+        std::vector<std::pair<int, uint64_t>> counts;
+        std::vector<Move> best, avoid;
+
+        while (not rest.empty()) {
+            auto const end = std::min(rest.find(';'), rest.size());
+            auto operands = trim(rest.substr(0, end));
+            rest.remove_prefix(std::min(end + 1, rest.size()));
+
+            auto const opcode = next_word(operands);
+            operands = trim(operands);
+
+            if (opcode == "id") {
+                id = operands;
+                if (id.size() >= 2 and id.front() == '"' and id.back() == '"')
+                    id = id.substr(1, id.size() - 2);
+            } else if (opcode.size() >= 2 and opcode.front() == 'D') {
+                int depth = 0;
+                uint64_t nodes = 0;
+                if (not parse_number(opcode.substr(1), depth) or
+                    depth < 1 or not parse_number(operands, nodes)) {
+                    totals.malformed.fetch_add(1, std::memory_order_relaxed);
+                    report(line_number, id, "bad perft operation");
+                    return;
+                }
+                counts.push_back({ depth, nodes });
+            } else if (opcode == "bm" or opcode == "am") {
+                auto& moves = opcode == "bm" ? best : avoid;
+                while (not operands.empty()) {
+                    auto const san = next_word(operands);
+                    auto const mv = parse_san(position->board, san);
+                    if (not mv) {
+                        totals.malformed.fetch_add(1,
+                                                   std::memory_order_relaxed);
+                        report(line_number,
+                               id,
+                               "bad move %.*s",
+                               int(san.size()),
+                               san.data());
+                        return;
+                    }
+                    moves.push_back(*mv);
+                }
+            }
+        }
+
+        if (settings.parse_only)
+            return;
+
+        auto board = position->board;
+
+        for (auto const& [depth, expected] : counts) {
+            if (depth > settings.max_perft_depth)
+                continue;
+
+            auto const nodes = perft(board, depth);
+            totals.perft_nodes.fetch_add(nodes, std::memory_order_relaxed);
+
+            if (nodes == expected) {
+                totals.perft_passed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                totals.perft_failed.fetch_add(1, std::memory_order_relaxed);
+                report(line_number,
+                       id,
+                       "D%d expected %llu, counted %llu",
+                       depth,
+                       static_cast<unsigned long long>(expected),
+                       static_cast<unsigned long long>(nodes));
+            }
+        }
+
+        if (best.empty() and avoid.empty())
+            return;
+
+        auto const result = search(board, settings.limits, *tables[worker]);
+        // no move to play, mate or stalemate, fails the test as well
+        if (result.pv.empty()) {
+            totals.moves_failed.fetch_add(1, std::memory_order_relaxed);
+            report(line_number, id, "no move searched");
+            return;
+        }
+
+        auto const played = result.pv.front();
+        bool const passed =
+          (best.empty() or std::ranges::count(best, played)) and
+          not std::ranges::count(avoid, played);
+
+        if (passed) {
+            totals.moves_passed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            totals.moves_failed.fetch_add(1, std::memory_order_relaxed);
+            report(line_number, id, "played %s", to_san(board, played).c_str());
+        }
+    }
+};
+
+void
+print_usage(char const* name)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--threads N] [--parse-only] [--perft-depth N] "
+                 "[--depth N] [--nodes N] [--time ms] [--hash MB] "
+                 "<file.epd>\n",
+                 name);
+}
+
+}
+
+// usage: epd [--threads N] [--parse-only] [--perft-depth N] [--depth N]
+//            [--nodes N] [--time ms] [--hash MB] <file.epd>
+// streams an EPD (or FEN) file and checks every line in parallel over
+// --threads threads (default every core):
+// -   "D<depth> <nodes>" operations, as in perft suites, are counted and
+//     compared, up to --perft-depth
+// -   "bm" and "am" are searched for --time ms (default 1000), or to --depth
+//     or --nodes, each thread with its own --hash MB table, and pass when a
+//     best move and none of the moves to avoid is played
+// Failures are printed as they happen, then a summary with the throughput.
+// --parse-only only loads the positions, to measure how fast that goes.
+int
+main(int const argc, char const* const* const argv)
+{
+    Settings settings{};
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    char const* path = nullptr;
+    bool limit_given = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{ argv[i] };
+        bool ok = true;
+
+        if (arg == "--parse-only") {
+            settings.parse_only = true;
+        } else if (arg.starts_with("--") and i + 1 < argc) {
+            std::string_view const value{ argv[++i] };
+            int64_t ms = 0;
+
+            if (arg == "--threads")
+                ok = parse_number(value, threads) and threads > 0;
+            else if (arg == "--perft-depth")
+                ok = parse_number(value, settings.max_perft_depth);
+            else if (arg == "--depth")
+                ok = limit_given = parse_number(value, settings.limits.depth);
+            else if (arg == "--nodes")
+                ok = limit_given = parse_number(value, settings.limits.nodes);
+            else if (arg == "--time") {
+                ok = limit_given = parse_number(value, ms);
+                settings.limits.time = std::chrono::milliseconds{ ms };
+            } else if (arg == "--hash")
+                ok = parse_number(value, settings.hash_mb);
+            else
+                ok = false;
+        } else if (not arg.starts_with("--") and not path) {
+            path = argv[i];
+        } else {
+            ok = false;
+        }
+
+        if (not ok) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (not path) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (not limit_given)
+        settings.limits.time = std::chrono::milliseconds{ 1000 };
+
+    std::ifstream file{ path };
+    if (not file) {
+        std::fprintf(stderr, "can't read %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    Runner runner{ .settings = settings };
+    if (not settings.parse_only)
+        for (std::size_t i = 0; i < threads; ++i)
+            runner.tables.push_back(
+              std::make_unique<TranspositionTable>(settings.hash_mb));
+
+    ThreadPool pool{ threads };
+    // batches read ahead of the threads, so a huge file is never all in
+    // memory at once
+    std::counting_semaphore<> in_flight{ std::ptrdiff_t(threads * 4) };
+
+    auto const start = std::chrono::steady_clock::now();
+
+    auto const submit = [&](Batch batch) {
+        in_flight.acquire();
+        pool.submit([&runner, &in_flight, batch = std::move(batch)](
+                      std::size_t const worker) {
+            for (std::size_t i = 0; i < batch.lines.size(); ++i)
+                runner.run(batch.lines[i], batch.first_line + i, worker);
+            in_flight.release();
+        });
+    };
+
+    std::size_t line_count = 0;
+    Batch batch{ .first_line = 1 };
+    std::string line;
+
+    while (std::getline(file, line)) {
+        ++line_count;
+        batch.lines.push_back(std::move(line));
+        if (batch.lines.size() == batch_size) {
+            submit(std::move(batch));
+            batch = { .first_line = line_count + 1 };
+        }
+    }
+    if (not batch.lines.empty())
+        submit(std::move(batch));
+
+    pool.wait();
+
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    auto const seconds = std::max(elapsed.count(), 1e-9);
+    auto const& totals = runner.totals;
+
+    std::printf("\n%llu positions from %zu lines, %llu malformed\n",
+                static_cast<unsigned long long>(totals.positions),
+                line_count,
+                static_cast<unsigned long long>(totals.malformed));
+    if (totals.perft_passed or totals.perft_failed)
+        std::printf("perft : %llu passed, %llu failed, %.0f nodes/second\n",
+                    static_cast<unsigned long long>(totals.perft_passed),
+                    static_cast<unsigned long long>(totals.perft_failed),
+                    totals.perft_nodes / seconds);
+    if (totals.moves_passed or totals.moves_failed)
+        std::printf("best moves : %llu passed, %llu failed\n",
+                    static_cast<unsigned long long>(totals.moves_passed),
+                    static_cast<unsigned long long>(totals.moves_failed));
+    std::printf("%.3f s, %.0f positions/second\n",
+                seconds,
+                totals.positions / seconds);
+
+    return totals.malformed or totals.perft_failed or totals.moves_failed
+             ? EXIT_FAILURE
+             : EXIT_SUCCESS;
+}
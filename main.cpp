@@ -5,225 +5,281 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdio>
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "Analysis.h"
 #include "CustomDeleters.hpp"
+#include "EmbeddedAssets.h"
 #include "Helpers.h"
 #include "Logic.h"
+#include "Notation.h"
 #include "Pieces.hpp"
+#include "PositionIndex.h"
+#include "Profile.h"
+#include "Timeline.hpp"
 
-SurfacePtr
-generate_board()
-{
-    int rmask, gmask, bmask, amask;
-    int rshift, gshift, bshift, ashift;
-
-    if constexpr (SDL_BYTEORDER == SDL_BIG_ENDIAN) {
-        rmask = 0xff000000;
-        gmask = 0x00ff0000;
-        bmask = 0x0000ff00;
-        amask = 0x000000ff;
-        rshift = 24;
-        gshift = 16;
-        bshift = 8;
-        ashift = 0;
-    } else {
-        rmask = 0x000000ff;
-        gmask = 0x0000ff00;
-        bmask = 0x00ff0000;
-        amask = 0xff000000;
-        rshift = 0;
-        gshift = 8;
-        bshift = 16;
-        ashift = 24;
-    }
-
-    // TODO: probably allow reading that from a config file / settings menu
-    constexpr SDL_Color const white_tile_colour{ 230, 204, 171, 0xFF };
-    constexpr SDL_Color const black_tile_colour{ 157, 87, 27, 0xFF };
-
-    constexpr auto const colour_switch =
-      std::to_array({ white_tile_colour, black_tile_colour });
-
-    // 8 * 8 pixel
-    auto board = SDL_CreateRGBSurface(0, 8, 8, 32, rmask, gmask, bmask, amask);
-
-    check_sdl_failure(not board, "Board creation");
-
-    Uint8* const pixel_data = static_cast<Uint8*>(board->pixels);
-
-    auto const pitch = board->pitch;
-
-    for (int y = 0; y < board->h; ++y) {
-        // switching from white to black every tile
-        bool current_colour = y & 1; // whether we start white, or black;
-        for (int x = 0; x < board->w; ++x) {
-            Uint32* const target_pixel = reinterpret_cast<Uint32*>(
-              pixel_data + y * pitch + x * sizeof(Uint32));
-
-            auto const [r, g, b, a] = colour_switch[current_colour];
-
-            *target_pixel =
-              r << rshift | b << bshift | g << gshift | a << ashift;
-
-            current_colour = not current_colour;
-        }
-    }
-    return to_ptr(board);
-}
+// TODO: probably allow reading that from a config file / settings menu
+constexpr SDL_Color white_tile_colour{ 230, 204, 171, 0xFF };
+constexpr SDL_Color black_tile_colour{ 157, 87, 27, 0xFF };
 
+// every sprite lives in one texture so a whole frame is drawn with a single
+// texture bound, the rects say where each one is in it
 struct Assets
 {
-    std::array<std::array<SDL_Texture*, PieceType::Count>, 2> pieces;
-
-    SDL_Texture* cursor{};
-    SDL_Texture* board{};
+    SDL_Texture* atlas{};
+    int atlas_w{}, atlas_h{};
+
+    std::array<std::array<SDL_Rect, PieceType::Count>, 2> pieces{};
+    SDL_Rect cursor{};
+    // plain white, tinted by the vertex colour to draw tiles and highlights
+    SDL_Rect white{};
+
+    Assets() = default;
+    Assets(Assets const&) = delete;
+    Assets(Assets&& other) noexcept
+      : atlas{ std::exchange(other.atlas, nullptr) }
+      , atlas_w{ other.atlas_w }
+      , atlas_h{ other.atlas_h }
+      , pieces{ other.pieces }
+      , cursor{ other.cursor }
+      , white{ other.white }
+    {}
 
     ~Assets()
     {
-        for (auto const& arr : pieces) {
-            for (auto* const ptr : arr) {
-                SDL_Log("Destroying Texture");
-                SDL_DestroyTexture(ptr);
-            }
-        }
-
-        SDL_DestroyTexture(board);
-        SDL_DestroyTexture(cursor);
+        SDL_Log("Destroying Texture");
+        SDL_DestroyTexture(atlas);
     }
 };
 
-Assets
-load_assets(RendererPtr const& renderer)
+// the image from the override directory when it has one, the one compiled
+// into the game otherwise
+SurfacePtr
+load_image(std::optional<std::filesystem::path> const& assets_dir,
+           std::string const& name)
 {
-    namespace fs = std::filesystem;
+    if (assets_dir) {
+        auto const path = *assets_dir / (name + ".png");
 
-    fs::path const assets_dir{ "./assets" };
+        if (std::filesystem::exists(path)) {
+            auto surface = to_ptr(IMG_Load(path.c_str()));
+            check_img_failure(not surface.get(), "Image loading");
+            return surface;
+        }
 
-    auto const flags = IMG_INIT_PNG;
+        SDL_Log("%s not found, using the embedded one\n", path.c_str());
+    }
 
-    check_img_failure(not(IMG_Init(flags) & flags), "Error init IMG");
+    auto const* const image = find_embedded_image(name);
+    check_sdl_failure(not image, "Missing embedded image");
+
+    // SDL wants a mutable pointer, the pixels are only ever read from
+    auto surface = to_ptr(SDL_CreateRGBSurfaceWithFormatFrom(
+      const_cast<unsigned char*>(image->rgba),
+      image->w,
+      image->h,
+      32,
+      image->w * 4,
+      SDL_PIXELFORMAT_RGBA32));
+    check_sdl_failure(not surface.get(), "Surface from embedded image");
+    return surface;
+}
 
-    Assets assets;
+// assets_dir replaces any image it holds, eg.: <assets_dir>/cursor.png
+Assets
+load_assets(RendererPtr const& renderer,
+            std::optional<std::filesystem::path> const& assets_dir)
+{
+    // decoding PNGs is only needed for the override
+    auto const flags = IMG_INIT_PNG;
+    if (assets_dir)
+        check_img_failure(not(IMG_Init(flags) & flags), "Error init IMG");
 
     static auto const piece_colour =
       std::to_array({ std::string("piece_white"), std::string("piece_black") });
 
-    // loading pieces
+    // loading pieces, eg.: piece_black5
+    std::array<std::array<SurfacePtr, PieceType::Count>, 2> pieces;
     for (int i = 0; auto const& name : piece_colour) {
-        for (int j = 0; auto*& piece : assets.pieces[i]) {
-            // create path eg.: ./assets/piece_black5.png
-            auto const dir =
-              assets_dir / (name + static_cast<char>('0' + j) + ".png");
-
-            auto const surface = to_ptr(IMG_Load(dir.c_str()));
-            check_img_failure(not surface.get(), "Image loading");
-
-            auto* const texture =
-              SDL_CreateTextureFromSurface(renderer.get(), surface.get());
-
-            check_sdl_failure(not texture, "Texture from image surface");
-
-            // freeing this will be handled by the assets destructor
-            piece = texture;
-
+        for (int j = 0; auto& piece : pieces[i]) {
+            piece = load_image(assets_dir, name + static_cast<char>('0' + j));
             ++j;
         }
         ++i;
     }
 
-    // loading cursor
-    {
-        auto const surface =
-          to_ptr(IMG_Load((assets_dir / "cursor.png").c_str()));
-        check_img_failure(not surface.get(), "Cursor loading");
+    auto const cursor = load_image(assets_dir, "cursor");
 
-        auto* const texture =
-          SDL_CreateTextureFromSurface(renderer.get(), surface.get());
-        check_sdl_failure(not texture, "Texture from cursor surface");
+    if (assets_dir)
+        IMG_Quit();
 
-        assets.cursor = texture;
-    }
-
-    // generating board
-    {
-        auto* const texture =
-          SDL_CreateTextureFromSurface(renderer.get(), generate_board().get());
-
-        check_sdl_failure(not texture, "Texture from board surface");
-
-        assets.board = texture;
-    }
+    // one cell per sprite: a row per colour with the cursor and the white
+    // cell in an extra column
+    int cell = cursor->w;
+    for (auto const& row : pieces)
+        for (auto const& piece : row)
+            cell = std::max({ cell, piece->w, piece->h });
 
-    IMG_Quit();
+    Assets assets;
+    assets.atlas_w = (PieceType::Count + 1) * cell;
+    assets.atlas_h = 2 * cell;
+
+    auto const atlas = to_ptr(SDL_CreateRGBSurfaceWithFormat(
+      0, assets.atlas_w, assets.atlas_h, 32, SDL_PIXELFORMAT_RGBA32));
+    check_sdl_failure(not atlas.get(), "Atlas creation");
+
+    // copies the alpha as is instead of blending onto the empty atlas
+    auto const place =
+      [&](SDL_Surface* const sprite, int const x, int const y) {
+          SDL_Rect rect{
+              .x = x * cell, .y = y * cell, .w = sprite->w, .h = sprite->h
+          };
+          SDL_SetSurfaceBlendMode(sprite, SDL_BLENDMODE_NONE);
+          check_sdl_failure(
+            SDL_BlitSurface(sprite, nullptr, atlas.get(), &rect) != 0,
+            "Blitting into the atlas");
+          return rect;
+      };
+
+    for (int i = 0; i < 2; ++i)
+        for (int j = 0; j < PieceType::Count; ++j)
+            assets.pieces[i][j] = place(pieces[i][j].get(), j, i);
+
+    assets.cursor = place(cursor.get(), PieceType::Count, 0);
+
+    assets.white = {
+        .x = PieceType::Count * cell, .y = cell, .w = cell, .h = cell
+    };
+    SDL_FillRect(atlas.get(),
+                 &assets.white,
+                 SDL_MapRGBA(atlas->format, 0xFF, 0xFF, 0xFF, 0xFF));
+    // only ever sample its middle so filtering never reaches the neighbours
+    assets.white = { .x = assets.white.x + cell / 2,
+                     .y = assets.white.y + cell / 2,
+                     .w = 1,
+                     .h = 1 };
+
+    assets.atlas = SDL_CreateTextureFromSurface(renderer.get(), atlas.get());
+    check_sdl_failure(not assets.atlas, "Texture from atlas surface");
+    SDL_SetTextureBlendMode(assets.atlas, SDL_BLENDMODE_BLEND);
 
     return assets;
 }
 
-BoardInfo
-generate_default_game_data()
+// quads from the atlas piled up during a frame and handed to the renderer
+// in one SDL_RenderGeometry call, the vectors keep their capacity between
+// frames
+struct SpriteBatch
 {
-    BoardInfo data{};
-    auto& [pieces, board, turn] = data;
-
-    using namespace PieceType;
-    using namespace Colour;
-    using namespace LetterColumn;
-
-    for (auto& arr : board)
-        for (auto& val : arr)
-            val = -1;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
 
-    for (auto const [colour, column, add] :
-         { std::tuple{ black, 8, 0 }, { white, 1, 8 } }) {
+    void add(Assets const& assets,
+             SDL_Rect const& src,
+             SDL_Rect const& dst,
+             SDL_Color const colour = { 0xFF, 0xFF, 0xFF, 0xFF })
+    {
+        auto const first = static_cast<int>(vertices.size());
 
-        for (int8_t i = 0;
-             auto const type :
-             { rook, knight, bishop, queen, king, bishop, knight, rook }) {
+        auto const u0 = float(src.x) / assets.atlas_w;
+        auto const v0 = float(src.y) / assets.atlas_h;
+        auto const u1 = float(src.x + src.w) / assets.atlas_w;
+        auto const v1 = float(src.y + src.h) / assets.atlas_h;
 
-            int8_t const index = add + i;
+        auto const x0 = float(dst.x);
+        auto const y0 = float(dst.y);
+        auto const x1 = float(dst.x + dst.w);
+        auto const y1 = float(dst.y + dst.h);
 
-            pieces[index] = {
-                .type = type,
-                .pos{ i, Y(column) },
-                .colour = colour,
-                .special = false,
-            };
+        vertices.push_back({ { x0, y0 }, colour, { u0, v0 } });
+        vertices.push_back({ { x1, y0 }, colour, { u1, v0 } });
+        vertices.push_back({ { x1, y1 }, colour, { u1, v1 } });
+        vertices.push_back({ { x0, y1 }, colour, { u0, v1 } });
 
-            board[i][Y(column)] = index;
-            ++i;
-        }
+        for (auto const i : { 0, 1, 2, 0, 2, 3 })
+            indices.push_back(first + i);
     }
 
-    // if i don’t want pawns to test things up i can remove this
-#if 1
-
-    // TODO: cleanup, tried to generalize but doesn't look good
-    for (auto [colour, column, add] :
-         { std::tuple{ bool{ black }, 7, 0 }, { white, 2, 8 } }) {
+    // a solid rectangle of the given colour
+    void fill(Assets const& assets, SDL_Rect const& dst, SDL_Color const colour)
+    {
+        add(assets, assets.white, dst, colour);
+    }
 
-        for (int8_t i = A; i <= H; ++i) {
+    // a solid quad of any shape, corners in order around it
+    void fill(Assets const& assets,
+              std::array<SDL_FPoint, 4> const& corners,
+              SDL_Color const colour)
+    {
+        auto const first = static_cast<int>(vertices.size());
+        SDL_FPoint const uv{ (assets.white.x + 0.5f) / assets.atlas_w,
+                             (assets.white.y + 0.5f) / assets.atlas_h };
 
-            int8_t index = 16 + add + i;
+        for (auto const corner : corners)
+            vertices.push_back({ corner, colour, uv });
 
-            pieces[index] = {
-                .type = pawn,
-                .pos{ i, Y(column) },
-                .colour = colour,
-                .special = false,
-            };
+        for (auto const i : { 0, 1, 2, 0, 2, 3 })
+            indices.push_back(first + i);
+    }
 
-            board[i][Y(column)] = index;
-        }
+    // a shaft `width` wide from `from` and a head ending on `to`
+    void arrow(Assets const& assets,
+               SDL_FPoint const from,
+               SDL_FPoint const to,
+               float const width,
+               SDL_Color const colour)
+    {
+        auto const length = std::hypot(to.x - from.x, to.y - from.y);
+        if (length < 1)
+            return;
+
+        // along the arrow, and across it
+        SDL_FPoint const along{ (to.x - from.x) / length,
+                                (to.y - from.y) / length };
+        SDL_FPoint const across{ -along.y * width / 2, along.x * width / 2 };
+
+        auto const head = std::min(width * 2.5f, length / 2);
+        SDL_FPoint const neck{ to.x - along.x * head, to.y - along.y * head };
+
+        fill(assets,
+             { SDL_FPoint{ from.x + across.x, from.y + across.y },
+               SDL_FPoint{ neck.x + across.x, neck.y + across.y },
+               SDL_FPoint{ neck.x - across.x, neck.y - across.y },
+               SDL_FPoint{ from.x - across.x, from.y - across.y } },
+             colour);
+        // a triangle, as a quad with two corners on the tip
+        fill(assets,
+             { SDL_FPoint{ neck.x + across.x * 2.5f, neck.y + across.y * 2.5f },
+               to,
+               to,
+               SDL_FPoint{ neck.x - across.x * 2.5f,
+                           neck.y - across.y * 2.5f } },
+             colour);
     }
-#endif
 
-    return data;
-}
+    void draw(SDL_Renderer* const renderer, Assets const& assets)
+    {
+        PROFILE_ZONE("draw");
+
+        SDL_RenderGeometry(renderer,
+                           assets.atlas,
+                           vertices.data(),
+                           static_cast<int>(vertices.size()),
+                           indices.data(),
+                           static_cast<int>(indices.size()));
+        vertices.clear();
+        indices.clear();
+    }
+};
 
 struct WindowData
 {
@@ -246,53 +302,283 @@ struct WindowData
 
 // TODO: pass in a struct has all necessary information on the window
 void
-render_board(Assets const& assets,
+render_board(SpriteBatch& batch,
+             Assets const& assets,
              BoardInfo const& board_info,
              WindowData& window_data)
 {
+    PROFILE_ZONE("render_board");
+
     auto const [w, h] = window_data.size();
     // SDL_Log("width : %d, height : %d\n", w, h);
     SDL_Rect tile{ .x = 0, .y = 0, .w = w / 8, .h = h / 8 };
 
     // TODO: handle screen resize and scale this in a rectangle
-    SDL_Rect screen_rect{ .x = 0, .y = 0, .w = w, .h = h };
-
-    auto* renderer = window_data.renderer();
-
-    SDL_RenderCopy(renderer, assets.board, nullptr, &screen_rect);
-
-#if 0
-    for (auto const& arr : board_info.board) {
-        for (auto const ptr : arr) {
-            if (ptr != -1) {
-                auto& [type, pos, colour, special, alive] =
-                  board_info.pieces[ptr];
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            tile.x = x * tile.w;
+            tile.y = y * tile.h;
+            // switching from white to black every tile
+            batch.fill(assets,
+                       tile,
+                       (x + y) & 1 ? black_tile_colour : white_tile_colour);
+        }
+    }
 
+    for (bool const colour : { Colour::white, Colour::black }) {
+        for (int type = 0; type < PieceType::Count; ++type) {
+            for (auto bb = board_info.pieces[colour][type]; bb;) {
+                auto const pos = to_position(pop_lsb(bb));
                 tile.x = pos.x * tile.w;
                 tile.y = pos.y * tile.h;
 
-                SDL_RenderCopy(
-                  renderer, assets.pieces[colour][type], nullptr, &tile);
+                batch.add(assets, assets.pieces[colour][type], tile);
             }
         }
     }
+}
 
-#else
-    for (auto const pc : board_info.pieces) {
-        if (pc.alive) {
-            tile.x = pc.pos.x * tile.w;
-            tile.y = pc.pos.y * tile.h;
+// frames drawn and time spent drawing them, shown in the window title once
+// a second while enabled. With the loop only drawing when something changed,
+// an idle board shows 0 fps.
+struct FrameCounter
+{
+    bool enabled = false;
+    int frames = 0;
+    double busy_ms = 0;
+    uint32_t window_start = 0;
 
-            SDL_RenderCopy(
-              renderer, assets.pieces[pc.colour][pc.type], nullptr, &tile);
+    void add(double const frame_ms) noexcept
+    {
+        ++frames;
+        busy_ms += frame_ms;
+    }
+
+    void report(SDL_Window* const win, uint32_t const now)
+    {
+        auto const elapsed = now - window_start;
+        if (elapsed < 1000)
+            return;
+
+        if (enabled) {
+            char title[64];
+            std::snprintf(title,
+                          sizeof(title),
+                          "Chess game - %.0f fps, %.2f ms/frame",
+                          frames * 1000.0 / elapsed,
+                          frames ? busy_ms / frames : 0.0);
+            SDL_SetWindowTitle(win, title);
         }
+
+        frames = 0;
+        busy_ms = 0;
+        window_start = now;
     }
+};
 
-#endif
-}
+// A runs the engine in the background on whatever position is on screen:
+// an arrow shows its best move so far and the bar on the left edge how good
+// the position is for white (bottom) or black (top)
+struct AnalysisView
+{
+    // pushed by the search thread so the loop wakes up to draw its updates
+    Uint32 wake_event = Uint32(-1);
+    std::optional<Analysis> analysis;
+    uint64_t request = 0;
+    // the position that request was about
+    uint64_t hash = 0;
+    std::size_t ply = 0;
+    std::optional<AnalysisUpdate> latest;
+
+    void toggle()
+    {
+        if (analysis) {
+            // waits for the search to notice it was cancelled, a few ms
+            analysis.reset();
+            latest.reset();
+            return;
+        }
+
+        Analysis::Notify notify;
+        if (wake_event != Uint32(-1)) {
+            notify = [event = wake_event] {
+                SDL_Event e{};
+                e.type = event;
+                SDL_PushEvent(&e);
+            };
+        }
+        analysis.emplace(16, std::move(notify));
+        request = 0;
+    }
+
+    // hands the shown position over when it changed and takes in what came
+    // back, never waits. Returns whether there is something new to draw
+    bool update(GameData const& game_data,
+                BoardInfo const& shown,
+                std::size_t const shown_ply)
+    {
+        if (not analysis)
+            return false;
+
+        bool changed = false;
+
+        if (request == 0 or shown.hash != hash or shown_ply != ply) {
+            hash = shown.hash;
+            ply = shown_ply;
+            request =
+              analysis->analyse(shown, game_data.hashes_before(shown_ply));
+            latest.reset();
+            changed = true;
+        }
+
+        // updates about positions no longer shown are skipped
+        while (auto const update = analysis->poll()) {
+            if (update->request == request) {
+                latest = *update;
+                changed = true;
+            }
+        }
+
+        return changed;
+    }
+
+    void draw(SpriteBatch& batch,
+              Assets const& assets,
+              int const tile_width,
+              int const tile_height) const
+    {
+        if (not analysis)
+            return;
+
+        // share of the bar that is white, even until the first update
+        double white_share = 0.5;
+        if (latest) {
+            auto const score =
+              latest->turn == Colour::white ? latest->score : -latest->score;
+            if (Score::is_mate(score))
+                white_share = score > 0 ? 1 : 0;
+            else
+                white_share = 1 / (1 + std::exp(-score / 400.0));
+        }
+
+        auto const bar_height = tile_height * 8;
+        auto const white_height = int(bar_height * white_share);
+        SDL_Rect bar{ .x = 0, .y = 0, .w = tile_width / 8, .h = bar_height };
+        batch.fill(assets, bar, { 40, 40, 40, 220 });
+        bar.y = bar_height - white_height;
+        bar.h = white_height;
+        batch.fill(assets, bar, { 240, 240, 240, 220 });
+
+        if (not latest or latest->pv_length == 0)
+            return;
+
+        auto const centre = [&](Position const p) {
+            return SDL_FPoint{ (p.x + 0.5f) * tile_width,
+                               (p.y + 0.5f) * tile_height };
+        };
+        auto const best = latest->pv[0];
+        batch.arrow(assets,
+                    centre(best.from),
+                    centre(best.where),
+                    tile_width / 8.0f,
+                    { 230, 80, 30, 200 });
+    }
+};
+
+// with --book, what was played from the position on screen in that index:
+// an arrow per move as wide as its share of the games, from red to green by
+// how it scored for the side playing it, and the numbers in the log. B
+// hides it
+struct BookView
+{
+    static constexpr std::size_t max_arrows = 5;
+
+    std::optional<PositionIndex> index;
+    bool shown = true;
+    bool looked_up = false;
+    // the position looked up
+    uint64_t hash = 0;
+    Colour::Colour turn = Colour::white;
+    // most played first
+    std::vector<IndexEntry> moves;
+    uint64_t games = 0;
+
+    void toggle()
+    {
+        shown = not shown;
+        looked_up = false;
+    }
+
+    // looks the position up when it changed, a few microseconds straight
+    // from the mapping. Returns whether there is something new to draw
+    bool update(BoardInfo const& board)
+    {
+        if (not index or not shown or (looked_up and board.hash == hash))
+            return false;
+
+        looked_up = true;
+        hash = board.hash;
+        turn = board.turn;
+
+        auto const found = index->find(hash);
+        moves.assign(found.begin(), found.end());
+        std::ranges::sort(moves, [](IndexEntry const& a, IndexEntry const& b) {
+            return a.games() > b.games();
+        });
+        games = 0;
+        for (auto const& entry : moves)
+            games += entry.games();
+
+        std::string line = "book : " + std::to_string(games) + " games";
+        for (auto const& entry : moves)
+            line += ", " + to_san(board, unpack_move(entry.move)) + " " +
+                    std::to_string(entry.games());
+        SDL_Log("%s\n", line.c_str());
+
+        return true;
+    }
+
+    void draw(SpriteBatch& batch,
+              Assets const& assets,
+              int const tile_width,
+              int const tile_height) const
+    {
+        if (not index or not shown or not games)
+            return;
+
+        auto const centre = [&](Position const p) {
+            return SDL_FPoint{ (p.x + 0.5f) * tile_width,
+                               (p.y + 0.5f) * tile_height };
+        };
+
+        auto const wins = turn == Colour::white ? GameResult::white_wins
+                                                : GameResult::black_wins;
+
+        for (std::size_t i = 0; i < std::min(moves.size(), max_arrows); ++i) {
+            auto const& entry = moves[i];
+            auto const share = float(entry.games()) / games;
+            auto const score =
+              (entry.results[wins] + entry.results[GameResult::draw] / 2.0f) /
+              entry.games();
+            auto const mv = unpack_move(entry.move);
+
+            batch.arrow(assets,
+                        centre(mv.from),
+                        centre(mv.where),
+                        tile_width * (0.04f + 0.2f * share),
+                        { Uint8(220 - 160 * score),
+                          Uint8(60 + 140 * score),
+                          60,
+                          170 });
+        }
+    }
+};
 
 void
-game(Assets const& assets, GameData& game_data, WindowData& window_data)
+game(Assets const& assets,
+     GameData& game_data,
+     WindowData& window_data,
+     std::optional<PositionIndex> book)
 {
     auto* main_renderer = window_data.renderer();
 
@@ -301,42 +587,128 @@ game(Assets const& assets, GameData& game_data, WindowData& window_data)
     int mouse_x, mouse_y;
     uint32_t prev_mouse_state{}, mouse_state{};
 
-    MoveContainer moves{};
+    MoveList moves{};
 
     BoardInfo::PeekResult selection{};
 
+    // H replays the game without blocking: space pauses, arrows step,
+    // page up/down skip 10 plies, home/end and 1-9 seek
+    Timeline timeline{};
+
     // while SDL cursor takes an int, i find this more explicit
     SDL_ShowCursor(SDL_DISABLE);
 
     bool run{ true };
+    // something on screen changed since the last frame
+    bool dirty{ true };
+    // F toggles the fps counter
+    FrameCounter frame_counter{};
+    SpriteBatch batch{};
+    AnalysisView analysis_view{ .wake_event = SDL_RegisterEvents(1) };
+    BookView book_view{ .index = std::move(book) };
 
     while (run) {
-        // SDL_WaitEvent(nullptr);
+        // sleep until there is input or the replay has to move, instead of
+        // spinning on SDL_PollEvent
         SDL_Event e;
-        while (SDL_PollEvent(&e)) {
+        bool has_event;
+        if (timeline.active and timeline.playing) {
+            auto const now = SDL_GetTicks();
+            auto const wait =
+              timeline.next_step > now ? int(timeline.next_step - now) : 0;
+            has_event = SDL_WaitEventTimeout(&e, wait);
+        } else {
+            has_event = SDL_WaitEvent(&e);
+        }
+
+        for (; has_event; has_event = SDL_PollEvent(&e)) {
+            PROFILE_ZONE("event");
+
             switch (e.type) {
                 case SDL_QUIT: {
                     run = false;
                 } break;
 
+                // the cursor is drawn by us, it moving is a change too
+                case SDL_MOUSEMOTION:
+                case SDL_MOUSEBUTTONDOWN:
+                case SDL_MOUSEBUTTONUP:
+                case SDL_WINDOWEVENT: {
+                    dirty = true;
+                } break;
+
                     // if i press H i should see all the previous
                     // states
                 case SDL_KEYUP: {
+                    dirty = true;
+
                     switch (e.key.keysym.scancode) {
-                        // debug
+                        // replay the game, the frame loop moves it along
                         case SDL_SCANCODE_H: {
                             SDL_Log("Pressed H\n");
-                            for (auto const& prev : game_data.history) {
-                                render_board(assets, prev, window_data);
-                                SDL_RenderPresent(main_renderer);
-                                SDL_Delay(500);
-                                SDL_Log("frame\n");
-                            }
+                            if (timeline.active)
+                                timeline.close();
+                            else
+                                timeline.open(game_data, SDL_GetTicks());
+                            selection.reset();
+                        } break;
+                        case SDL_SCANCODE_SPACE: {
+                            timeline.toggle(SDL_GetTicks());
+                        } break;
+                        case SDL_SCANCODE_LEFT: {
+                            timeline.step(game_data, -1);
+                        } break;
+                        case SDL_SCANCODE_RIGHT: {
+                            timeline.step(game_data, 1);
+                        } break;
+                        case SDL_SCANCODE_PAGEUP: {
+                            timeline.step(game_data, -10);
+                        } break;
+                        case SDL_SCANCODE_PAGEDOWN: {
+                            timeline.step(game_data, 10);
+                        } break;
+                        case SDL_SCANCODE_HOME: {
+                            timeline.step(game_data, -int(timeline.ply));
+                        } break;
+                        case SDL_SCANCODE_END: {
+                            timeline.playing = false;
+                            timeline.seek(game_data, game_data.ply_count());
+                        } break;
+                        case SDL_SCANCODE_A: {
+                            analysis_view.toggle();
+                        } break;
+                        case SDL_SCANCODE_B: {
+                            book_view.toggle();
+                        } break;
+                        case SDL_SCANCODE_F: {
+                            frame_counter.enabled = not frame_counter.enabled;
+                            if (not frame_counter.enabled)
+                                SDL_SetWindowTitle(window_data.get(),
+                                                   "Chess game");
                         } break;
                         case SDL_SCANCODE_ESCAPE: {
                             run = false;
                         } break;
 
+                        // 1 to 9 jump to that tenth of the game
+                        case SDL_SCANCODE_1:
+                        case SDL_SCANCODE_2:
+                        case SDL_SCANCODE_3:
+                        case SDL_SCANCODE_4:
+                        case SDL_SCANCODE_5:
+                        case SDL_SCANCODE_6:
+                        case SDL_SCANCODE_7:
+                        case SDL_SCANCODE_8:
+                        case SDL_SCANCODE_9: {
+                            if (not timeline.active)
+                                break;
+                            auto const tenth =
+                              e.key.keysym.scancode - SDL_SCANCODE_1 + 1;
+                            timeline.playing = false;
+                            timeline.seek(game_data,
+                                          game_data.ply_count() * tenth / 10);
+                        } break;
+
                         default: {
                         } break;
                     }
@@ -346,6 +718,11 @@ game(Assets const& assets, GameData& game_data, WindowData& window_data)
         }
         mouse_state = SDL_GetMouseState(&mouse_x, &mouse_y);
 
+        if (timeline.update(game_data, SDL_GetTicks())) {
+            SDL_Log("replay at ply %zu\n", timeline.ply);
+            dirty = true;
+        }
+
         auto const [win_w, win_h] = window_data.size();
         auto const tile_width = win_w / 8;
         auto const tile_height = win_h / 8;
@@ -355,9 +732,11 @@ game(Assets const& assets, GameData& game_data, WindowData& window_data)
 
         SDL_Rect tile{ .x{}, .y{}, .w = tile_width, .h = tile_height };
 
-        // released
-        if (not(mouse_state & SDL_BUTTON(SDL_BUTTON_LEFT)) and
+        // released, the board can't be played on while replaying
+        if (not timeline.active and
+            not(mouse_state & SDL_BUTTON(SDL_BUTTON_LEFT)) and
             prev_mouse_state & SDL_BUTTON(SDL_BUTTON_LEFT)) {
+            PROFILE_ZONE("click");
 
             // if clicking out of a move allows to recheck
             bool keep_checking;
@@ -383,56 +762,20 @@ game(Assets const& assets, GameData& game_data, WindowData& window_data)
                     } else { // TODO: handle clicked on a valid move
                         SDL_Log("valid move ! %s\n",
                                 res->move_type ? "takes" : "doesn't take");
-                        auto const& [where, takes] = *res;
-
-                        game_data.save();
-
                         // MUTATES GAME DATA
-                        //  take piece
-                        switch (takes) {
-                            using namespace MoveType;
-                            case move: {
-                                board.move(selection, where);
-                            } break;
-                            case take: {
-                                // get piece at that position, then mark it as
-                                // dead
-                                auto& target_piece = board.get(where).value();
-                                target_piece.alive = false;
-
-                                board.take(where);
-
-                                if (target_piece.type == PieceType::king) {
-                                    SDL_Log(
-                                      "%s won.\n",
-                                      Colour::names[selection.value().colour]);
-                                }
-
-                                board.move(selection, where);
-
-                            } break;
-                            case en_passant: {
-                                // the move is either one over or one under the
-                                // piece we are taking
-                                int8_t y =
-                                  where.y + (selection.value().colour ? -1 : 1);
-
-                                auto& target_piece =
-                                  board.get(where.x, y).value();
-
-                                target_piece.alive = false;
-
-                                board.take({ where.x, y });
-
-                                board.move(selection, where);
-
-                            } break;
-                                // TODO: castle
-                            case castle: {
-                            } break;
+                        // a promotion is the first of the moves to that
+                        // square, always a queen
+                        game_data.play(*res);
+
+                        MoveList replies;
+                        get_all_moves(board, replies);
+                        if (replies.empty() and in_check(board, board.turn)) {
+                            SDL_Log("%s won.\n",
+                                    Colour::names[selection.value().colour]);
+                        } else if (replies.empty()) {
+                            SDL_Log("stalemate.\n");
                         }
 
-                        board.switch_turn();
                         selection.reset();
                     }
 
@@ -449,7 +792,8 @@ game(Assets const& assets, GameData& game_data, WindowData& window_data)
                                 PieceType::names[piece_selected.value().type]);
 
                         selection = piece_selected;
-                        moves = get_moves(piece_selected.value(), game_data);
+                        moves.clear();
+                        get_moves(piece_selected.value(), board, moves);
                     } else {
                         selection.reset();
                     }
@@ -457,26 +801,56 @@ game(Assets const& assets, GameData& game_data, WindowData& window_data)
             } while (keep_checking);
         }
 
+        prev_mouse_state = mouse_state;
+
+        if (analysis_view.update(game_data,
+                                 timeline.active ? timeline.board : board,
+                                 timeline.active ? timeline.ply
+                                                 : game_data.ply_count()))
+            dirty = true;
+
+        if (book_view.update(timeline.active ? timeline.board : board))
+            dirty = true;
+
+        if (not dirty)
+            continue;
+        dirty = false;
+
+        PROFILE_ZONE("frame");
+
+        auto const frame_start = SDL_GetPerformanceCounter();
+
+        // the whole frame is a single draw call
         SDL_RenderClear(main_renderer);
-        render_board(assets, board, window_data);
+        render_board(batch,
+                     assets,
+                     timeline.active ? timeline.board : board,
+                     window_data);
         if (selection) {
             for (auto const move : moves) {
                 tile.x = move.where.x * tile_width;
                 tile.y = move.where.y * tile_height;
-                if (not move.move_type) {
-                    SDL_SetRenderDrawColor(main_renderer, 0, 100, 200, 200);
-                } else {
-                    SDL_SetRenderDrawColor(main_renderer, 0, 200, 100, 200);
-                }
-                SDL_RenderFillRect(main_renderer, &tile);
+                batch.fill(assets,
+                           tile,
+                           not move.move_type ? SDL_Color{ 0, 100, 200, 200 }
+                                              : SDL_Color{ 0, 200, 100, 200 });
             }
         }
 
+        book_view.draw(batch, assets, tile_width, tile_height);
+        analysis_view.draw(batch, assets, tile_width, tile_height);
+
         SDL_Rect cursor_rect{ .x = mouse_x, .y = mouse_y, .w = 50, .h = 50 };
-        SDL_RenderCopy(main_renderer, assets.cursor, nullptr, &cursor_rect);
-        SDL_RenderPresent(main_renderer);
+        batch.add(assets, assets.cursor, cursor_rect);
+        batch.draw(main_renderer, assets);
+        {
+            PROFILE_ZONE("present");
+            SDL_RenderPresent(main_renderer);
+        }
 
-        prev_mouse_state = mouse_state;
+        frame_counter.add((SDL_GetPerformanceCounter() - frame_start) *
+                          1000.0 / SDL_GetPerformanceFrequency());
+        frame_counter.report(window_data.get(), SDL_GetTicks());
     }
 
     // while SDL cursor takes an int, i find this more explicit
@@ -504,7 +878,29 @@ main(int const argc, char const* const* const argv)
 
     SDL_SetWindowMinimumSize(main_window.get(), width / 10, height / 10);
 
-    auto const render_flags = SDL_RENDERER_ACCELERATED;
+    // --vsync lets the driver hold each frame until the next refresh,
+    // --assets <dir> loads the images found there instead of the embedded
+    // ones, --profile <file> writes a Chrome trace of the session on exit
+    // (needs -DCHESS_PROFILE=ON), --book <index> shows the moves played
+    // from each position in an index built by `book --build`
+    Uint32 render_flags = SDL_RENDERER_ACCELERATED;
+    std::optional<std::filesystem::path> assets_dir;
+    char const* profile_path = nullptr;
+    std::optional<PositionIndex> book;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{ argv[i] };
+        if (arg == "--vsync")
+            render_flags |= SDL_RENDERER_PRESENTVSYNC;
+        else if (arg == "--assets" and i + 1 < argc)
+            assets_dir = argv[++i];
+        else if (arg == "--profile" and i + 1 < argc)
+            profile_path = argv[++i];
+        else if (arg == "--book" and i + 1 < argc) {
+            book = PositionIndex::open(argv[++i]);
+            if (not book)
+                SDL_Log("%s isn't a position index, no book\n", argv[i]);
+        }
+    }
 
     // TODO: figure out if i need to store the renderer since it is
     // associated to the window
@@ -514,7 +910,7 @@ main(int const argc, char const* const* const argv)
     assert(main_renderer.get() == SDL_GetRenderer(main_window.get()));
 
     // data structure containing all textures representing games pieces
-    auto const assets = load_assets(main_renderer);
+    auto const assets = load_assets(main_renderer, assets_dir);
 
     check_sdl_failure(not main_renderer.get(), "Renderer creation");
 
@@ -523,5 +919,8 @@ main(int const argc, char const* const* const argv)
     GameData game_data = { .current_board{ generate_default_game_data() },
                            .history{} };
 
-    game(assets, game_data, main_window);
+    game(assets, game_data, main_window, std::move(book));
+
+    if (profile_path)
+        Profile::report(profile_path);
 }
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Fen.h"
+#include "Logic.h"
+#include "Notation.h"
+#include "Perft.h"
+#include "Profile.h"
+#include "ThreadPool.h"
+
+namespace {
+
+void
+print_usage(char const* name)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--threads N] [--hash MB] [--bench] "
+                 "[--profile trace.json] [--fen FEN] <depth> [moves...]\n",
+                 name);
+}
+
+struct Run
+{
+    std::vector<uint64_t> counts; // below each root move
+    uint64_t nodes = 0;
+    double seconds = 0;
+};
+
+Run
+run(BoardInfo const& board,
+    int const depth,
+    std::size_t const threads,
+    std::size_t const hash_mb)
+{
+    // built before the clock starts, neither is part of the walk
+    ThreadPool pool{ threads };
+    auto const table =
+      hash_mb ? std::make_unique<PerftTable>(hash_mb) : nullptr;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    Run result{ .counts = parallel_perft(board, depth, pool, table.get()) };
+
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+
+    for (auto const count : result.counts)
+        result.nodes += count;
+
+    return result;
+}
+
+double
+nodes_per_second(Run const& r)
+{
+    return r.seconds > 0 ? r.nodes / r.seconds : 0.0;
+}
+
+}
+
+// usage: perft [--threads N] [--hash MB] [--bench] [--profile trace.json]
+//              [--fen FEN] <depth> [moves...]
+// counts the leaves of the move tree from the starting position, or --fen,
+// after playing the given moves (eg.: "e2e4 e7e5"), printing the count below
+// every root move. The tree is split over --threads threads (default every core),
+// --hash skips transpositions with a table of that size (default none).
+// --bench runs the same count with 1, 2, 4, ... threads up to --threads and
+// prints how the throughput scales. --profile writes where the time went
+// as a Chrome trace, in builds configured with -DCHESS_PROFILE=ON.
+int
+main(int const argc, char const* const* const argv)
+{
+    std::size_t threads =
+      std::max(1u, std::thread::hardware_concurrency());
+    std::size_t hash_mb = 0;
+    bool bench_mode = false;
+    char const* profile_path = nullptr;
+    std::string_view fen;
+    int depth = 0;
+    std::vector<std::string_view> played;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{ argv[i] };
+        bool ok = true;
+
+        if (arg == "--bench")
+            bench_mode = true;
+        else if (arg == "--threads" and i + 1 < argc)
+            ok = parse_number(std::string_view{ argv[++i] }, threads) and
+                 threads > 0;
+        else if (arg == "--hash" and i + 1 < argc)
+            ok = parse_number(std::string_view{ argv[++i] }, hash_mb);
+        else if (arg == "--profile" and i + 1 < argc)
+            profile_path = argv[++i];
+        else if (arg == "--fen" and i + 1 < argc)
+            fen = argv[++i];
+        else if (arg.starts_with("--"))
+            ok = false;
+        else if (depth == 0)
+            ok = parse_number(arg, depth) and depth > 0;
+        else
+            played.push_back(arg);
+
+        if (not ok) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (depth == 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    GameData game_data{ .current_board{ generate_default_game_data() },
+                        .history{} };
+
+    if (not fen.empty()) {
+        auto const position = parse_fen(fen);
+        if (not position) {
+            std::fprintf(
+              stderr, "bad fen : %.*s\n", int(fen.size()), fen.data());
+            return EXIT_FAILURE;
+        }
+        game_data.current_board = position->board;
+    }
+
+    for (auto const str : played) {
+        auto const mv = parse_move(game_data.current_board, str);
+        if (not mv) {
+            std::fprintf(
+              stderr, "illegal move : %.*s\n", int(str.size()), str.data());
+            return EXIT_FAILURE;
+        }
+        game_data.play(*mv);
+    }
+
+    auto const& board = game_data.current_board;
+
+    if (bench_mode) {
+        std::printf("%8s %16s %10s %14s %8s\n",
+                    "threads",
+                    "nodes",
+                    "time (s)",
+                    "nodes/second",
+                    "speedup");
+
+        std::optional<Run> single;
+
+        for (std::size_t n = 1; n <= threads; n *= 2) {
+            auto const r = run(board, depth, n, hash_mb);
+            if (not single)
+                single = r;
+
+            std::printf("%8zu %16llu %10.3f %14.0f %7.2fx\n",
+                        n,
+                        static_cast<unsigned long long>(r.nodes),
+                        r.seconds,
+                        nodes_per_second(r),
+                        nodes_per_second(r) /
+                          std::max(nodes_per_second(*single), 1.0));
+            std::fflush(stdout);
+
+            if (r.nodes != single->nodes) {
+                std::fprintf(stderr,
+                             "count differs from the single thread one\n");
+                return EXIT_FAILURE;
+            }
+        }
+    } else {
+        auto const r = run(board, depth, threads, hash_mb);
+
+        MoveList moves;
+        get_all_moves(board, moves);
+
+        for (std::size_t i = 0; i < moves.size(); ++i)
+            std::printf("%s: %llu\n",
+                        to_string(moves[i]).c_str(),
+                        static_cast<unsigned long long>(r.counts[i]));
+
+        std::printf("\nNodes searched: %llu\n",
+                    static_cast<unsigned long long>(r.nodes));
+        std::printf("Time: %.3f s\n", r.seconds);
+        std::printf("Nodes/second: %.0f\n", nodes_per_second(r));
+    }
+
+    if (profile_path and not Profile::report(profile_path))
+        return EXIT_FAILURE;
+}
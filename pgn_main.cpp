@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Logic.h"
+#include "MappedFile.h"
+#include "Notation.h"
+#include "Pgn.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// first moves listed in the summary
+constexpr std::size_t top_first_moves = 5;
+
+// what a thread has seen, summed once all files are read
+struct Tally
+{
+    std::array<uint64_t, GameResult::names.size()> results{};
+    // by packed first move of games from the standard start
+    std::vector<uint64_t> first_moves = std::vector<uint64_t>(1 << 16);
+
+    void add(Tally const& other)
+    {
+        for (std::size_t i = 0; i < results.size(); ++i)
+            results[i] += other.results[i];
+        for (std::size_t i = 0; i < first_moves.size(); ++i)
+            first_moves[i] += other.first_moves[i];
+    }
+};
+
+void
+print_usage(char const* name)
+{
+    std::fprintf(stderr, "usage: %s [--threads N] <file.pgn>...\n", name);
+}
+
+}
+
+// usage: pgn [--threads N] <file.pgn>...
+// reads every game of the files, mapped into memory and split between
+// --threads threads (default every core), and prints how fast that went in
+// games per second with a few numbers about the games to check they were
+// read right: results, average length and the most played first moves.
+int
+main(int const argc, char const* const* const argv)
+{
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<char const*> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{ argv[i] };
+
+        if (arg == "--threads" and i + 1 < argc) {
+            if (not parse_number(std::string_view{ argv[++i] }, threads) or
+                not threads) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (not arg.starts_with("--")) {
+            paths.push_back(argv[i]);
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (paths.empty()) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool{ threads };
+    std::vector<Tally> tallies(pool.size());
+    auto const standard = generate_default_game_data();
+
+    auto const on_game = [&](PgnGame const& game, std::size_t const worker) {
+        auto& tally = tallies[worker];
+        ++tally.results[game.result];
+        if (not game.moves.empty() and game.start.hash == standard.hash)
+            ++tally.first_moves[game.moves.front()];
+    };
+
+    PgnStats stats{};
+    uint64_t bytes = 0;
+    auto const start = std::chrono::steady_clock::now();
+
+    for (auto const* const path : paths) {
+        auto const file = MappedFile::open(path);
+        if (not file) {
+            std::fprintf(stderr, "can't read %s\n", path);
+            return EXIT_FAILURE;
+        }
+        stats += read_pgn(file->text(), pool, on_game);
+        bytes += file->size();
+    }
+
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    auto const seconds = std::max(elapsed.count(), 1e-9);
+
+    Tally total{};
+    for (auto const& tally : tallies)
+        total.add(tally);
+
+    std::printf("%llu games, %llu plies, %llu skipped\n",
+                static_cast<unsigned long long>(stats.games),
+                static_cast<unsigned long long>(stats.plies),
+                static_cast<unsigned long long>(stats.errors));
+
+    if (stats.games) {
+        std::printf("results :");
+        for (std::size_t i = 0; i < total.results.size(); ++i)
+            std::printf(" %s %.1f%%",
+                        GameResult::names[i],
+                        100.0 * total.results[i] / stats.games);
+        std::printf("\naverage length : %.1f plies\n",
+                    double(stats.plies) / stats.games);
+    }
+
+    std::vector<uint16_t> firsts;
+    for (std::size_t i = 0; i < total.first_moves.size(); ++i)
+        if (total.first_moves[i])
+            firsts.push_back(static_cast<uint16_t>(i));
+    auto const shown = std::min(firsts.size(), top_first_moves);
+    std::partial_sort(firsts.begin(),
+                      firsts.begin() + shown,
+                      firsts.end(),
+                      [&](uint16_t const a, uint16_t const b) {
+                          return total.first_moves[a] > total.first_moves[b];
+                      });
+    if (shown) {
+        std::printf("first moves :");
+        for (std::size_t i = 0; i < shown; ++i)
+            std::printf(" %s %llu",
+                        to_san(standard, unpack_move(firsts[i])).c_str(),
+                        static_cast<unsigned long long>(
+                          total.first_moves[firsts[i]]));
+        std::putchar('\n');
+    }
+
+    std::printf("%.3f s, %.0f games/second, %.1f MB/second\n",
+                seconds,
+                stats.games / seconds,
+                bytes / seconds / (1 << 20));
+
+    return EXIT_SUCCESS;
+}
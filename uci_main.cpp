@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Fen.h"
+#include "Log.h"
+#include "Logic.h"
+#include "Notation.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+namespace {
+
+// the search thread prints info lines while this one answers isready, each
+// line goes out whole
+std::mutex output_mutex;
+
+void
+send(char const* format, ...) CHESS_PRINTF_FORMAT(1, 2);
+
+void
+send(char const* const format, ...)
+{
+    std::lock_guard lock{ output_mutex };
+
+    va_list args;
+    va_start(args, format);
+    std::vprintf(format, args);
+    va_end(args);
+
+    std::putchar('\n');
+    std::fflush(stdout);
+}
+
+std::vector<std::string_view>
+split(std::string_view line)
+{
+    std::vector<std::string_view> words;
+
+    while (true) {
+        auto const begin = line.find_first_not_of(" \t\r");
+        if (begin == line.npos)
+            return words;
+        line.remove_prefix(begin);
+
+        auto const end = std::min(line.find_first_of(" \t\r"), line.size());
+        words.push_back(line.substr(0, end));
+        line.remove_prefix(end);
+    }
+}
+
+struct Engine
+{
+    GameData game{ .current_board{ generate_default_game_data() },
+                   .history{} };
+    TranspositionTable tt{ 16 };
+    int threads = 1;
+
+    std::atomic<bool> stop = false;
+    // raised when a go infinite or ponder search may print its bestmove
+    std::atomic<bool> released = false;
+    std::jthread searcher;
+
+    // a go ponder search runs until ponderhit, then for the time the go
+    // command gave it, counted by this thread
+    bool pondering = false;
+    std::chrono::milliseconds ponder_time{};
+    std::jthread ponder_timer;
+
+    // stops the running search, if any, and waits for its bestmove
+    void finish()
+    {
+        if (not searcher.joinable())
+            return;
+
+        // asks the timer to stop and joins it
+        ponder_timer = {};
+        pondering = false;
+        stop.store(true);
+        released.store(true);
+        released.notify_one();
+        searcher.join();
+    }
+
+    void set_option(std::vector<std::string_view> const& words)
+    {
+        // setoption name <id> value <x>, ids are case insensitive
+        auto const name_at = std::ranges::find(words, "name");
+        auto const value_at = std::ranges::find(words, "value");
+        if (name_at == words.end() or value_at == words.end() or
+            name_at + 2 != value_at or value_at + 1 == words.end()) {
+            send("info string expected setoption name <id> value <x>");
+            return;
+        }
+
+        std::string name{ name_at[1] };
+        std::ranges::transform(name, name.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        auto const value = value_at[1];
+
+        std::size_t number = 0;
+        if (not parse_number(value, number)) {
+            send("info string bad value %.*s", int(value.size()), value.data());
+            return;
+        }
+
+        finish();
+
+        if (name == "hash")
+            tt.resize(std::clamp<std::size_t>(number, 1, 65536));
+        else if (name == "threads")
+            threads = static_cast<int>(std::clamp<std::size_t>(number, 1, 256));
+        else
+            send("info string unknown option %s", name.c_str());
+    }
+
+    // position (startpos | fen <fen>) [moves ...], stops at the first
+    // illegal move
+    void set_position(std::vector<std::string_view> const& words)
+    {
+        finish();
+
+        auto word = words.begin() + 1;
+        if (word != words.end() and *word == "startpos") {
+            game = { .current_board{ generate_default_game_data() },
+                     .history{} };
+            ++word;
+        } else if (word != words.end() and *word == "fen") {
+            // the fields up to "moves", still in one piece in the line
+            auto const first = ++word;
+            word = std::find(first, words.end(), "moves");
+            if (first == word) {
+                send("info string expected a fen");
+                return;
+            }
+
+            auto const last = word - 1;
+            std::string_view const fen{ first->data(),
+                                        static_cast<std::size_t>(
+                                          last->data() + last->size() -
+                                          first->data()) };
+            auto const position = parse_fen(fen);
+            if (not position) {
+                send("info string bad fen %.*s", int(fen.size()), fen.data());
+                return;
+            }
+            game = { .current_board{ position->board }, .history{} };
+        } else {
+            send("info string expected position startpos|fen [moves ...]");
+            return;
+        }
+
+        if (word == words.end() or *word != "moves")
+            return;
+
+        for (++word; word != words.end(); ++word) {
+            auto const mv = parse_move(game.current_board, *word);
+            if (not mv) {
+                send("info string illegal move %.*s",
+                     int(word->size()),
+                     word->data());
+                return;
+            }
+            game.play(*mv);
+        }
+    }
+
+    void go(std::vector<std::string_view> const& words)
+    {
+        finish();
+
+        auto const us = game.current_board.turn;
+        SearchLimits limits{ .stop = &stop, .threads = threads };
+        bool infinite = false;
+        bool ponder = false;
+        int64_t time_left = -1;
+        int64_t increment = 0;
+        int64_t moves_to_go = 0;
+
+        for (std::size_t i = 1; i < words.size(); ++i) {
+            auto const word = words[i];
+
+            if (word == "infinite") {
+                infinite = true;
+                continue;
+            }
+            // the clock below is for once the move pondered on is played,
+            // on ponderhit, until then the search goes on
+            if (word == "ponder") {
+                ponder = true;
+                continue;
+            }
+
+            // everything else takes a value, bad ones are ignored
+            if (i + 1 == words.size())
+                break;
+            auto const value = words[++i];
+            int64_t ms = 0;
+
+            if (word == "depth")
+                (void)parse_number(value, limits.depth);
+            else if (word == "nodes")
+                (void)parse_number(value, limits.nodes);
+            else if (word == "movetime" and parse_number(value, ms))
+                limits.time = std::chrono::milliseconds{ ms };
+            else if (word == (us == Colour::white ? "wtime" : "btime"))
+                (void)parse_number(value, time_left);
+            else if (word == (us == Colour::white ? "winc" : "binc"))
+                (void)parse_number(value, increment);
+            else if (word == "movestogo")
+                (void)parse_number(value, moves_to_go);
+        }
+
+        // a share of what is left plus most of the increment, never so much
+        // that the flag could fall
+        if (time_left >= 0 and limits.time.count() == 0 and not infinite) {
+            auto const share = time_left / (moves_to_go ? moves_to_go : 30);
+            auto const budget = std::min(share + increment * 3 / 4,
+                                         time_left - 50);
+            limits.time = std::chrono::milliseconds{ std::max<int64_t>(
+              budget, 1) };
+        }
+
+        pondering = ponder;
+        if (ponder) {
+            ponder_time = limits.time;
+            limits.time = {};
+        }
+
+        bool const held = infinite or ponder;
+        stop.store(false);
+        released.store(not held);
+
+        searcher = std::jthread{ [this, limits, held] {
+            auto const previous = game.hashes_before(game.ply_count());
+
+            auto const result = search(
+              game.current_board,
+              limits,
+              tt,
+              [this](SearchInfo const& info) {
+                  std::string pv;
+                  for (auto const mv : info.pv)
+                      pv += " " + to_string(mv);
+
+                  send("info depth %d score %s nodes %llu nps %llu time %lld "
+                       "hashfull %d pv%s",
+                       info.depth,
+                       format_score(info.score).c_str(),
+                       static_cast<unsigned long long>(info.nodes),
+                       static_cast<unsigned long long>(info.nps),
+                       static_cast<long long>(info.elapsed.count()),
+                       tt.hashfull(),
+                       pv.c_str());
+              },
+              previous);
+
+            // go infinite only answers once told to stop, go ponder not
+            // before ponderhit, even when the search ran out of depth
+            if (held)
+                released.wait(false);
+
+            // search gives a move whenever there is one, however early it
+            // was stopped, so the null move only answers mate and stalemate
+            if (result.pv.empty())
+                send("bestmove 0000");
+            else
+                send("bestmove %s", to_string(result.pv.front()).c_str());
+        } };
+    }
+
+    // the move pondered on was played: the search goes on as the go
+    // command asked without ponder, its time counted from now
+    void ponder_hit()
+    {
+        if (not pondering)
+            return;
+        pondering = false;
+
+        if (ponder_time.count()) {
+            ponder_timer = std::jthread{ [this, budget = ponder_time](
+                                           std::stop_token const token) {
+                std::mutex mutex;
+                std::condition_variable_any cv;
+                std::unique_lock lock{ mutex };
+                (void)cv.wait_for(lock, token, budget, [] { return false; });
+                // also when asked to stop, finish raises it then anyway
+                stop.store(true);
+            } };
+        }
+
+        released.store(true);
+        released.notify_one();
+    }
+};
+
+}
+
+// usage: chess_uci
+// speaks UCI on stdin and stdout. Commands are read on this thread while the
+// search runs on its own, so stop lands within a millisecond or so. Knows
+// uci, isready, ucinewgame, setoption (Hash in MB, Threads), position
+// (startpos | fen <fen>) [moves ...], go (depth, nodes, movetime, wtime,
+// btime, winc, binc, movestogo, infinite, ponder), ponderhit, stop and quit.
+int
+main()
+{
+    Engine engine;
+    std::string line;
+
+    while (std::getline(std::cin, line)) {
+        auto const words = split(line);
+        if (words.empty())
+            continue;
+
+        auto const command = words.front();
+
+        if (command == "uci") {
+            send("id name chess");
+            send("id author chess contributors");
+            send("option name Hash type spin default 16 min 1 max 65536");
+            send("option name Threads type spin default 1 min 1 max 256");
+            send("uciok");
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "ucinewgame") {
+            engine.finish();
+            engine.tt.clear();
+        } else if (command == "setoption") {
+            engine.set_option(words);
+        } else if (command == "position") {
+            engine.set_position(words);
+        } else if (command == "go") {
+            engine.go(words);
+        } else if (command == "stop") {
+            engine.finish();
+        } else if (command == "ponderhit") {
+            engine.ponder_hit();
+        } else if (command == "quit") {
+            break;
+        } else {
+            send("info string unknown command %.*s",
+                 int(command.size()),
+                 command.data());
+        }
+    }
+
+    engine.finish();
+}